@@ -43,5 +43,9 @@ enum MPRINT_OPTIONS	{
 	MPRINT_OPT_CONSOLE 	= 1,
 	MPRINT_OPT_FILE 	= 2	};
 
+enum MATCH_ENGINE	{
+	MATCH_ENGINE_VF2 	= 0,
+	MATCH_ENGINE_RI 	= 1	};
+
 
 #endif /* OPTIONS_H_ */
@@ -39,6 +39,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <iostream>
 #include <fstream>
 #include <string.h>
+#include <algorithm>
 
 #include "LabelMap.h"
 #include "typedefs.h"
@@ -47,7 +48,7 @@ namespace GRAPESLib{
 
 #define STR_READ_LENGTH 256
 
-typedef short vf2_count_type;
+typedef int vf2_count_type;
 typedef unsigned short vf2_node_id;
 const vf2_node_id NULL_NODE=0xFFFF;
 
@@ -164,41 +165,17 @@ public:
 		return NULL;
 	}
 
+	//adjacency lists come from linked lists in reverse order, quicksort on the last element would be quadratic on hubs
 	void sort_edges(VF2Graph* g){
 		for(int i=0;i<g->n;i++){
 			if(g->out_count[i]>1){
-				quicksort_edges(g->out[i], 0, g->out_count[i] -1);
+				std::sort(g->out[i], g->out[i] + g->out_count[i]);
 			}
 			if(g->in_count[i]>1){
-				quicksort_edges(g->in[i], 0, g->in_count[i] -1);
+				std::sort(g->in[i], g->in[i] + g->in_count[i]);
 			}
 		}
 	}
-	void quicksort_edges(vf2_node_id* adj_list, int p, int r){
-		if(p<r){
-			int q=quicksort_edges_partition(adj_list, p, r);
-			quicksort_edges(adj_list, p, q-1);
-			quicksort_edges(adj_list, q+1, r);
-		}
-	}
-	int quicksort_edges_partition(vf2_node_id* adj_list, int p, int r){
-		vf2_node_id ltmp;
-		vf2_node_id target = adj_list[r];
-		int i = p-1;
-		for(int j=p; j<r; j++){
-			//if(adj_list[j] < target || (adj_list[j]==target  && (edgeComparator.compareint(adj_attrs[j], attr)<=0))){
-			if(adj_list[j] < target){
-				i++;
-				ltmp = adj_list[i];
-				adj_list[i] = adj_list[j];
-				adj_list[j] = ltmp;
-			}
-		}
-		ltmp = adj_list[i+1];
-		adj_list[i+1] = adj_list[r];
-		adj_list[r] = ltmp;
-		return i+1;
-	}
 
 	virtual VF2Graph* readSGraph(){
 
@@ -305,15 +282,27 @@ public:
 				graph->in = new vf2_node_id*[graph->n];
 				graph->out = new vf2_node_id*[graph->n];
 
+				//adjacency lists are consecutive slices of one array per direction (CSR), the graph is never modified
+				long nof_edges = 0;
+				for (i=0; i<graph->n; i++)
+					nof_edges += graph->out_count[i];
+				vf2_node_id* in_edges = new vf2_node_id[nof_edges];
+				vf2_node_id* out_edges = new vf2_node_id[nof_edges];
+				void** in_attrs = new void*[nof_edges];
+				void** out_attrs = new void*[nof_edges];
+
 				int* ink = (int*)calloc(graph->n, sizeof(int));
+				long in_offset = 0, out_offset = 0;
 				for (i=0; i<graph->n; i++){
-					graph->in[i] = new vf2_node_id[ graph->in_count[i] ];
-					graph->in_attr[i] = new void*[graph->in_count[i]];
+					graph->in[i] = in_edges + in_offset;
+					graph->in_attr[i] = in_attrs + in_offset;
+					in_offset += graph->in_count[i];
 				}
 				for (i=0; i<graph->n; i++){
 					// reading degree and successors of vertex i
-					graph->out[i] = new vf2_node_id[ graph->out_count[i] ];
-					graph->out_attr[i] = new void*[graph->out_count[i]];
+					graph->out[i] = out_edges + out_offset;
+					graph->out_attr[i] = out_attrs + out_offset;
+					out_offset += graph->out_count[i];
 
 					gr_neighs_t *n = ns_o[i];
 					for (j=0; j<graph->out_count[i]; j++){
@@ -364,6 +353,7 @@ public:
 				}
 
 				sort_edges(graph);
+				graph->BuildEdgeIndex();
 
 				return graph;
 			}
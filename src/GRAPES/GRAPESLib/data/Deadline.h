@@ -0,0 +1,77 @@
+/*
+ * Deadline.h
+ *
+ */
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DEADLINE_H_
+#define DEADLINE_H_
+
+#include <atomic>
+
+#include "timer.h"
+
+namespace GRAPESLib{
+
+/*
+ * Time budget of a query, shared by the filtering and the verification phases.
+ * Phases poll it cooperatively: once it has passed, or it has been cancelled,
+ * each phase stops at its next check and keeps the results found so far.
+ * The expired flag is set by one thread and read by all the others.
+ */
+class Deadline{
+	//seconds from the start, 0 for no limit
+	double budget;
+	TIMEHANDLE start;
+	std::atomic<bool> expired;
+
+public:
+	Deadline(double _budget = 0)
+			: budget(_budget){
+		start = start_time();
+		expired.store(false, std::memory_order_relaxed);
+	}
+
+	//it reads the clock, so hot loops should call it every some iterations and use hasExpired in between
+	inline bool passed(){
+		if(!expired.load(std::memory_order_acquire) && budget > 0 && end_time(start) >= budget)
+			expired.store(true, std::memory_order_release);
+		return expired.load(std::memory_order_acquire);
+	}
+
+	inline bool hasExpired() const{
+		return expired.load(std::memory_order_acquire);
+	}
+
+	//it stops the query as if its budget had passed
+	inline void cancel(){
+		expired.store(true, std::memory_order_release);
+	}
+};
+
+}
+
+#endif /* DEADLINE_H_ */
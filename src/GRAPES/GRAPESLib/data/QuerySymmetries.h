@@ -0,0 +1,181 @@
+/*
+ * QuerySymmetries.h
+ *
+ */
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef QUERYSYMMETRIES_H_
+#define QUERYSYMMETRIES_H_
+
+#include <vector>
+
+#include "size_t.h"
+#include "typedefs.h"
+
+namespace GRAPESLib{
+
+/*
+ * Symmetry breaking conditions of a query (Grochow and Kellis, 2007).
+ * Every embedding has |Aut(Q)| copies, one for each automorphism of the query,
+ * and exactly one of them maps the nodes of each condition to increasing target nodes:
+ * counting the embeddings satisfying the conditions, times |Aut(Q)|, counts all of them.
+ * Automorphisms preserve labels and edge directions.
+ */
+class QuerySymmetries{
+public:
+	//number of automorphisms of the query
+	u_lsize_t automorphisms;
+	//for each node, the nodes that must be matched to a greater target node
+	std::vector< std::vector<node_id_t> > greater;
+	//for each node, the nodes that must be matched to a smaller target node
+	std::vector< std::vector<node_id_t> > smaller;
+
+private:
+	node_id_t n;
+	std::vector<node_label_t> labels;
+	std::vector< std::vector<bool> > adj;
+
+	//@image holds the nodes already mapped, NULL_NODE for the others
+	bool extend(std::vector<node_id>& image, std::vector<bool>& used, node_id_t u){
+		if(u == n)
+			return true;
+		if(image[u] != NULL_NODE)
+			return consistent(image, u) && extend(image, used, u + 1);
+
+		for(node_id_t v=0; v<n; v++){
+			if(used[v] || labels[v] != labels[u])
+				continue;
+			image[u] = v;
+			used[v] = true;
+			if(consistent(image, u) && extend(image, used, u + 1))
+				return true;
+			image[u] = NULL_NODE;
+			used[v] = false;
+		}
+		return false;
+	}
+
+	//edges between u and the nodes before it are preserved both ways
+	bool consistent(std::vector<node_id>& image, node_id_t u){
+		for(node_id_t w=0; w<=u; w++){
+			if(image[w] == NULL_NODE)
+				continue;
+			if(adj[u][w] != adj[image[u]][image[w]] || adj[w][u] != adj[image[w]][image[u]])
+				return false;
+		}
+		return true;
+	}
+
+	//true if an automorphism fixing the @fixed nodes maps @v to @w
+	bool mappable(const std::vector<node_id_t>& fixed, node_id_t v, node_id_t w){
+		std::vector<node_id> image(n, NULL_NODE);
+		std::vector<bool> used(n, false);
+		if(labels[v] != labels[w])
+			return false;
+		for(size_t i=0; i<fixed.size(); i++){
+			image[fixed[i]] = fixed[i];
+			used[fixed[i]] = true;
+		}
+		if(used[w])
+			return false;
+		image[v] = w;
+		used[w] = true;
+		return extend(image, used, 0);
+	}
+
+public:
+	QuerySymmetries(QueryGraph& query, const std::vector<node_label_t>& _labels)
+			: labels(_labels){
+		::Graph& g = query;
+		n = g.NodeCount();
+		adj.assign(n, std::vector<bool>(n, false));
+		for(node_id_t u=0; u<n; u++)
+			for(int i=0; i<g.OutEdgeCount(u); i++)
+				adj[u][g.GetOutEdge(u, i)] = true;
+
+		greater.resize(n);
+		smaller.resize(n);
+		automorphisms = 1;
+
+		//stabilizer chain: fix the node with the largest orbit under the automorphisms fixing the previous ones
+		std::vector<node_id_t> fixed;
+		std::vector<bool> is_fixed(n, false);
+		while(true){
+			std::vector<node_id_t> best_orbit;
+			std::vector<bool> in_orbit(n, false);
+			node_id_t best = 0;
+
+			for(node_id_t v=0; v<n; v++){
+				if(is_fixed[v] || in_orbit[v])
+					continue;
+				std::vector<node_id_t> orbit(1, v);
+				for(node_id_t w=v+1; w<n; w++){
+					if(!is_fixed[w] && mappable(fixed, v, w)){
+						orbit.push_back(w);
+						in_orbit[w] = true;
+					}
+				}
+				if(orbit.size() > best_orbit.size()){
+					best_orbit = orbit;
+					best = v;
+				}
+			}
+			if(best_orbit.size() <= 1)
+				break;
+
+			for(size_t i=1; i<best_orbit.size(); i++){
+				greater[best].push_back(best_orbit[i]);
+				smaller[best_orbit[i]].push_back(best);
+			}
+			automorphisms *= best_orbit.size();
+			fixed.push_back(best);
+			is_fixed[best] = true;
+		}
+	}
+
+	inline bool isTrivial() const{
+		return automorphisms == 1;
+	}
+
+	//true if matching n1 to n2 satisfies the conditions, given the target of each query node in @mapping
+	inline bool allows(node_id_t n1, node_id_t n2, const node_id* mapping) const{
+		for(size_t i=0; i<greater[n1].size(); i++){
+			node_id other = mapping[greater[n1][i]];
+			if(other != NULL_NODE && n2 >= other)
+				return false;
+		}
+		for(size_t i=0; i<smaller[n1].size(); i++){
+			node_id other = mapping[smaller[n1][i]];
+			if(other != NULL_NODE && n2 <= other)
+				return false;
+		}
+		return true;
+	}
+};
+
+}
+
+#endif /* QUERYSYMMETRIES_H_ */
@@ -38,11 +38,16 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <set>
 #include <list>
 #include <map>
+#include <deque>
+#include <vector>
 
 #include "size_t.h"
 #include "typedefs.h"
 
+#include "Options.h"
 #include "AttributeComparator.h"
+#include "QuerySymmetries.h"
+#include "Deadline.h"
 
 namespace GRAPESLib{
 
@@ -56,10 +61,15 @@ public:
 	}
 };
 
+//(query node, target node) pairs
+typedef std::vector< std::pair<node_id_t, node_id_t> > match_prefix_t;
+
 class g_match_task_t{
 public:
 	graph_id_t first;
 	match_job_t second;
+	//pairs added to the pivot before the task was split from a larger one
+	match_prefix_t prefix;
 	g_match_task_t(){
 		first = -1;
 	}
@@ -68,15 +78,6 @@ public:
 	}
 };
 
-class MatchingJob{
-public:
-	g_match_task_t& coco;
-
-	MatchingJob(g_match_task_t& _coco)
-			: coco(_coco){
-	}
-};
-
 class MatchingManager{
 public:
 	pthread_mutex_t getajob_sync;
@@ -91,7 +92,6 @@ public:
 	filtering_graph_set_t::iterator graphs_IT;
 
 	std::list<g_match_task_t> coco_units;
-	std::list<g_match_task_t>::iterator coco_units_mIT;
 
 	AttributeComparator& edgeComparator;
 
@@ -99,6 +99,44 @@ public:
 	std::set<graph_id_t>* matching_graphs;
 	u_size_t* number_of_cocos;
 
+	//** work stealing **//
+	thread_id_t nthreads;
+	//each thread pops from the back of its own deque, and steals from the front of the others
+	std::deque<g_match_task_t>* task_queues;
+	pthread_mutex_t* task_queues_sync;
+	pthread_mutex_t pending_sync;
+	//signaled when a task is pushed or the last task is completed
+	pthread_cond_t pending_cond;
+	//tasks queued or running; matching ends when it drops to zero
+	u_lsize_t pending_tasks;
+	//threads waiting for a task
+	volatile int idle_threads;
+	//init and matching jobs are served by the same threads
+	bool pipelined;
+	//search algorithm used to verify the tasks
+	MATCH_ENGINE engine;
+	//symmetry breaking conditions of the query, NULL if every embedding has to be enumerated
+	QuerySymmetries* symmetries;
+	u_size_t* number_of_steals;
+	u_size_t* number_of_splits;
+
+	//** early termination **//
+	//matches to find in total and in each graph, 0 to find all of them
+	u_lsize_t match_limit;
+	u_lsize_t graph_match_limit;
+	//matches found so far, shared by the threads; per graph only if graph_match_limit is set
+	volatile u_lsize_t found_matches;
+	std::map<graph_id_t, u_lsize_t> graph_found_matches;
+	//tasks not matched because enough matches had already been found, or the time budget had passed
+	u_size_t* number_of_skips;
+
+	//** time budget **//
+	//NULL if the query has no time budget
+	Deadline* deadline;
+	//progress of each phase, to report what a timed out query did
+	u_size_t reduced_graphs;
+	u_size_t* number_of_verified;
+
 
 	MatchingManager(
 					QueryGraph& _query,
@@ -116,6 +154,28 @@ public:
 		matching_graphs = new std::set<graph_id_t>[NTHREADS];
 		number_of_cocos = (u_size_t*)calloc(NTHREADS, sizeof(u_size_t));
 
+		nthreads = NTHREADS;
+		task_queues = new std::deque<g_match_task_t>[NTHREADS];
+		task_queues_sync = new pthread_mutex_t[NTHREADS];
+		for(thread_id_t i=0; i<NTHREADS; i++)
+			task_queues_sync[i] = PTHREAD_MUTEX_INITIALIZER;
+		pending_sync = PTHREAD_MUTEX_INITIALIZER;
+		pending_cond = PTHREAD_COND_INITIALIZER;
+		pending_tasks = 0;
+		idle_threads = 0;
+		pipelined = false;
+		engine = MATCH_ENGINE_VF2;
+		symmetries = NULL;
+		number_of_steals = (u_size_t*)calloc(NTHREADS, sizeof(u_size_t));
+		number_of_splits = (u_size_t*)calloc(NTHREADS, sizeof(u_size_t));
+		match_limit = 0;
+		graph_match_limit = 0;
+		found_matches = 0;
+		number_of_skips = (u_size_t*)calloc(NTHREADS, sizeof(u_size_t));
+		deadline = NULL;
+		reduced_graphs = 0;
+		number_of_verified = (u_size_t*)calloc(NTHREADS, sizeof(u_size_t));
+
 		graphs_IT = fgset.begin();
 	}
 
@@ -123,9 +183,29 @@ public:
 		free(number_of_matches);
 		delete [] matching_graphs;
 		free(number_of_cocos);
+		delete [] task_queues;
+		delete [] task_queues_sync;
+		free(number_of_steals);
+		free(number_of_splits);
+		free(number_of_skips);
+		free(number_of_verified);
 	}
 
 	bool getAInitJob(thread_id_t thread, InitMatchingJob** mjob){
+		//after the time budget, the graphs still to be reduced are dropped
+		if(graphs_IT != fgset.end() && deadline != NULL && deadline->passed()){
+			u_lsize_t dropped = 0;
+			for(; graphs_IT != fgset.end(); graphs_IT++)
+				dropped++;
+			if(pipelined){
+				pthread_mutex_lock(&pending_sync);
+				pending_tasks -= dropped;
+				if(pending_tasks == 0)
+					pthread_cond_broadcast(&pending_cond);
+				pthread_mutex_unlock(&pending_sync);
+			}
+			return false;
+		}
 		if(graphs_IT !=  fgset.end()){
 			*mjob = new InitMatchingJob(*graphs_IT, *(graphs[*graphs_IT]));
 			graphs_IT++;
@@ -134,9 +214,28 @@ public:
 		return false;
 	}
 	void finishInitJob(thread_id_t thread, InitMatchingJob* job){
+		reduced_graphs++;
 		for(match_jobs_t::iterator IT = job->cocos.begin(); IT!=job->cocos.end(); IT++){
 			coco_units.push_back(g_match_task_t(job->g_id, *IT));
 		}
+
+		//in a pipelined run, the tasks of the reduced graph can be matched right away
+		if(pipelined){
+			pthread_mutex_lock(&pending_sync);
+			pending_tasks += job->cocos.size();
+			pthread_mutex_unlock(&pending_sync);
+
+			pthread_mutex_lock(&task_queues_sync[thread]);
+			for(match_jobs_t::iterator IT = job->cocos.begin(); IT!=job->cocos.end(); IT++){
+				task_queues[thread].push_back(g_match_task_t(job->g_id, *IT));
+			}
+			pthread_mutex_unlock(&task_queues_sync[thread]);
+
+			syncFinishMatchJob(thread);
+			pthread_mutex_lock(&pending_sync);
+			pthread_cond_broadcast(&pending_cond);
+			pthread_mutex_unlock(&pending_sync);
+		}
 	}
 	bool syncGetAInitJob(thread_id_t thread, InitMatchingJob** mjob){
 		pthread_mutex_lock(&getajob_sync);
@@ -155,28 +254,156 @@ public:
 
 
 
+	//tasks are dealt round robin to the threads' deques
 	void createBalancedRun(){
-		coco_units_mIT =  coco_units.begin();
+		thread_id_t t = 0;
+		for(std::list<g_match_task_t>::iterator IT = coco_units.begin(); IT!=coco_units.end(); IT++){
+			task_queues[t].push_back(*IT);
+			t = (t + 1) % nthreads;
+		}
+		pending_tasks = coco_units.size();
+		idle_threads = 0;
+		createMatchCounters();
 	}
 
 
+	/* each graph still to be reduced counts as a pending task, 
+	 * so that matching threads wait for the tasks it will produce */
+	void createPipelinedRun(){
+		pipelined = true;
+		pending_tasks = fgset.size();
+		idle_threads = 0;
+		createMatchCounters();
+	}
 
+	//the counters of every graph are created before matching starts, so threads never insert into the map
+	void createMatchCounters(){
+		found_matches = 0;
+		graph_found_matches.clear();
+		if(graph_match_limit > 0)
+			for(filtering_graph_set_t::iterator IT = fgset.begin(); IT!=fgset.end(); IT++)
+				graph_found_matches[*IT] = 0;
+	}
 
-	bool getAMatchJob(int thread, MatchingJob** mjob){
-		if(coco_units_mIT !=  coco_units.end()){
-			*mjob = new MatchingJob(*coco_units_mIT);
-			coco_units_mIT++;
-			return true;
+	//counter of the matches found in a graph, NULL if there is no limit per graph
+	volatile u_lsize_t* graphMatches(graph_id_t gid){
+		if(graph_match_limit == 0)
+			return NULL;
+		std::map<graph_id_t, u_lsize_t>::iterator IT = graph_found_matches.find(gid);
+		return IT != graph_found_matches.end() ? &(IT->second) : NULL;
+	}
+
+	//true if no more matches are needed from the graph counted by @graph_matches
+	inline bool enoughMatches(volatile u_lsize_t* graph_matches){
+		return (match_limit > 0 && found_matches >= match_limit)
+				|| (graph_matches != NULL && *graph_matches >= graph_match_limit);
+	}
+
+	//true once the time budget has passed; it only reads the flag, threads poll the clock with deadline->passed()
+	inline bool timedOut(){
+		return deadline != NULL && deadline->hasExpired();
+	}
+
+	/* it reserves a new match of the graph counted by @graph_matches, if the limits allow it;
+	 * the graph is counted first, so a match refused by the global limit can give its graph slot back */
+	bool claimMatch(volatile u_lsize_t* graph_matches){
+		if(graph_matches != NULL && __sync_add_and_fetch(graph_matches, 1) > graph_match_limit){
+			__sync_fetch_and_sub(graph_matches, 1);
+			return false;
 		}
-		return false;
+		if(match_limit > 0 && __sync_add_and_fetch(&found_matches, 1) > match_limit){
+			__sync_fetch_and_sub(&found_matches, 1);
+			if(graph_matches != NULL)
+				__sync_fetch_and_sub(graph_matches, 1);
+			return false;
+		}
+		return true;
 	}
 
-	bool syncGetAMatchJob(int thread, MatchingJob** mjob){
-		pthread_mutex_lock(&getajob_sync);
-		bool get = getAMatchJob(thread, mjob);
-		pthread_mutex_unlock(&getajob_sync);
+
+	bool popAMatchJob(int thread, g_match_task_t& task){
+		bool get = false;
+		pthread_mutex_lock(&task_queues_sync[thread]);
+		if(!task_queues[thread].empty()){
+			task = task_queues[thread].back();
+			task_queues[thread].pop_back();
+			get = true;
+		}
+		pthread_mutex_unlock(&task_queues_sync[thread]);
+		return get;
+	}
+
+	bool stealAMatchJob(int thread, g_match_task_t& task){
+		bool get = false;
+		for(thread_id_t i=1; i<nthreads && !get; i++){
+			thread_id_t victim = (thread + i) % nthreads;
+			pthread_mutex_lock(&task_queues_sync[victim]);
+			if(!task_queues[victim].empty()){
+				task = task_queues[victim].front();
+				task_queues[victim].pop_front();
+				get = true;
+			}
+			pthread_mutex_unlock(&task_queues_sync[victim]);
+		}
+		if(get)
+			number_of_steals[thread]++;
 		return get;
 	}
+
+	/* it returns false when every task has been completed;
+	 * while other threads are still running, new subtasks may be split from theirs */
+	bool syncGetAMatchJob(int thread, g_match_task_t& task){
+		if(popAMatchJob(thread, task) || stealAMatchJob(thread, task))
+			return true;
+
+		bool get = false;
+		pthread_mutex_lock(&pending_sync);
+		idle_threads++;
+		while(!get && pending_tasks > 0){
+			//pushes signal while holding pending_sync, so no task can be missed between the check and the wait
+			get = stealAMatchJob(thread, task) || popAMatchJob(thread, task);
+			if(!get)
+				pthread_cond_wait(&pending_cond, &pending_sync);
+		}
+		idle_threads--;
+		pthread_mutex_unlock(&pending_sync);
+		return get;
+	}
+
+	//it makes a subtask available for stealing
+	void syncPushMatchJob(int thread, g_match_task_t& task){
+		pthread_mutex_lock(&pending_sync);
+		pending_tasks++;
+		pthread_mutex_unlock(&pending_sync);
+
+		pthread_mutex_lock(&task_queues_sync[thread]);
+		task_queues[thread].push_back(task);
+		pthread_mutex_unlock(&task_queues_sync[thread]);
+		number_of_splits[thread]++;
+
+		pthread_mutex_lock(&pending_sync);
+		pthread_cond_signal(&pending_cond);
+		pthread_mutex_unlock(&pending_sync);
+	}
+
+	void syncFinishMatchJob(int thread){
+		pthread_mutex_lock(&pending_sync);
+		pending_tasks--;
+		if(pending_tasks == 0)
+			pthread_cond_broadcast(&pending_cond);
+		pthread_mutex_unlock(&pending_sync);
+	}
+
+	//threads sharing the candidate reduction of each graph, when there are fewer graphs than threads
+	thread_id_t reductionThreads(){
+		if(fgset.size() == 0 || fgset.size() >= (size_t)nthreads)
+			return 1;
+		return nthreads / fgset.size();
+	}
+
+	inline bool hasIdleThreads(){
+		return idle_threads > 0;
+	}
 };
 
 }
@@ -73,6 +73,7 @@ public:
 		int rc;
 		for(thread_id_t i=0;i<_n_threads;i++){
 			InitMatchingThread* mt = new InitMatchingThread(i, _mman, _query_size, *(_mman.edgeComparator.clone()), _n_threads);
+			mt->reduction_threads = _mman.reductionThreads();
 			rc = pthread_create(&bmatchingPThreads[i], NULL, InitMatchingThread::run, (void*)mt);
 			if(rc){
 				printf("ERROR; return code from pthread_create() is %d\n", rc);
@@ -90,6 +91,20 @@ public:
 
 	void runMatch(	std::map<graph_id_t, ReferenceGraph*>& graphs,
 					ARGEdit& query){
+		runMatch(graphs, query, false);
+	}
+
+	/* candidate reduction and matching overlapped: the same threads reduce the graphs, 
+	 * and match the connected components of each graph as soon as it has been reduced */
+	void runPipelined(	std::map<graph_id_t, ReferenceGraph*>& graphs,
+						ARGEdit& query){
+		_mman.createPipelinedRun();
+		runMatch(graphs, query, true);
+	}
+
+	void runMatch(	std::map<graph_id_t, ReferenceGraph*>& graphs,
+					ARGEdit& query,
+					bool pipelined){
 
 		pthread_t matchingPThreads[_n_threads];
 		std::ofstream outs[_n_threads];
@@ -120,6 +135,10 @@ public:
 													*(mlistener),
 													*(_mman.edgeComparator.clone()),
 													mprint_opt);
+			if(pipelined){
+				mt->init_thread = new InitMatchingThread(i, _mman, _query_size, *(_mman.edgeComparator.clone()), _n_threads);
+				mt->init_thread->reduction_threads = _mman.reductionThreads();
+			}
 
 			rc = pthread_create(&matchingPThreads[i], NULL, MatchingThread::run, (void*)mt);
 			if(rc){
@@ -39,6 +39,9 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <iostream>
 #include <stack>
+#include <vector>
+#include <algorithm>
+#include <pthread.h>
 #include <stdio.h>
 #include "math.h"
 
@@ -50,12 +53,118 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "vf2_mono_state.h"
 #include "vf2_sub_state.h"
 #include "match.h"
+#include "RIState.h"
 
 
 namespace GRAPESLib{
 
 
 
+class InitMatchingThread;
+
+/* state shared by the threads reducing the candidates of the same graph:
+ * each thread owns a range of target nodes, aligned to sbitset blocks,
+ * so that no two threads write the same block of a domain */
+class DomainReduction{
+public:
+	InitMatchingThread* ithread;
+	InitMatchingJob* job;
+	//candidates of each query node
+	sbitset** cands;
+	node_id_t query_nodes;
+	thread_id_t nworkers;
+	pthread_barrier_t barrier;
+
+	sbitset target_mask;
+	node_id_t* masked_in_degree;
+	node_id_t* masked_out_degree;
+	//union-find forest of the connected components, roots are the smallest nodes
+	node_id_t* parent;
+	//root of the component of each node, and size of each component
+	node_id_t* coco;
+	u_size_t* coco_size;
+
+	//out-neighbours of the nodes with a dense adjacency row, NULL for the other nodes
+	sbitset** out_rows;
+	/* query nodes whose domain has been refined by each worker in the last round;
+	 * rounds alternate between two halves, so that a worker can reset its flags while others still read the previous ones */
+	bool* worker_changed;
+
+	DomainReduction(InitMatchingThread* _ithread, InitMatchingJob* _job, sbitset** _cands, node_id_t _query_nodes, thread_id_t _nworkers)
+			: ithread(_ithread), job(_job), cands(_cands), query_nodes(_query_nodes), nworkers(_nworkers){
+		node_id_t n = job->graph.n;
+		target_mask.clear(n);
+		masked_in_degree =  (node_id_t*)calloc(n, sizeof(node_id_t));
+		masked_out_degree = (node_id_t*)calloc(n, sizeof(node_id_t));
+		parent = (node_id_t*)malloc(n * sizeof(node_id_t));
+		coco = (node_id_t*)malloc(n * sizeof(node_id_t));
+		coco_size = (u_size_t*)calloc(n, sizeof(u_size_t));
+		for(node_id_t i=0; i<n; i++)
+			parent[i] = i;
+		out_rows = (sbitset**)calloc(n, sizeof(sbitset*));
+		worker_changed = (bool*)calloc(2 * nworkers * query_nodes, sizeof(bool));
+		pthread_barrier_init(&barrier, NULL, nworkers);
+	}
+
+	~DomainReduction(){
+		free(masked_in_degree);
+		free(masked_out_degree);
+		free(parent);
+		free(coco);
+		free(coco_size);
+		for(node_id_t i=0; i<job->graph.n; i++)
+			delete out_rows[i];
+		free(out_rows);
+		free(worker_changed);
+		pthread_barrier_destroy(&barrier);
+	}
+
+	//nodes [from, to) owned by the worker
+	void workerRange(thread_id_t worker, node_id_t& from, node_id_t& to){
+		const u_size_t bits = sizeof(sbitset_block) * 8;
+		u_size_t nblocks = (job->graph.n + bits - 1) / bits;
+		from = std::min<u_size_t>(job->graph.n, (worker * nblocks / nworkers) * bits);
+		to = std::min<u_size_t>(job->graph.n, ((worker + 1) * nblocks / nworkers) * bits);
+	}
+
+	//first candidate not before @from
+	static sbitset::iterator firstOnes(sbitset& domain, node_id_t from){
+		const u_size_t bits = sizeof(sbitset_block) * 8;
+		sbitset::iterator IT(domain, std::min<u_size_t>(from / bits, domain._nblocks));
+		if(IT != domain.end() && !IT.second)
+			IT.next_ones();
+		return IT;
+	}
+
+	//the entries are read atomically, as other workers may be linking them
+	node_id_t find(node_id_t n){
+		node_id_t p;
+		while((p = __atomic_load_n(&parent[n], __ATOMIC_ACQUIRE)) != n)
+			n = p;
+		return n;
+	}
+
+	//lock-free union: a root is linked under the smaller one only if it is still a root
+	void unite(node_id_t a, node_id_t b){
+		while(true){
+			a = find(a);
+			b = find(b);
+			if(a == b)
+				return;
+			if(a < b)
+				std::swap(a, b);
+			if(__sync_bool_compare_and_swap(&parent[a], a, b))
+				return;
+		}
+	}
+};
+
+struct domain_reduction_worker_t{
+	DomainReduction* reduction;
+	thread_id_t worker;
+};
+
+
 class InitMatchingThread{
 public:
 	thread_id_t id;
@@ -65,6 +174,11 @@ public:
 
 	thread_id_t nthreads;
 
+	//threads reducing the candidates of a single graph
+	thread_id_t reduction_threads;
+	//smaller graphs are reduced by this thread only
+	node_id_t parallel_threshold;
+
 	InitMatchingThread(
 				thread_id_t _id,
 				MatchingManager& _mman,
@@ -76,269 +190,323 @@ public:
 		  query_size(_query_size),
 		  edgeComparator(_edgeComparator),
 		  nthreads(_nthreads){
+		reduction_threads = 1;
+		parallel_threshold = 4096;
 	}
 
-	void fillJob(InitMatchingJob* job){
-		node_id_t* masked_in_degree =  (node_id_t*)calloc(job->graph.n, sizeof(node_id_t));
-		node_id_t* masked_out_degree = (node_id_t*)calloc(job->graph.n, sizeof(node_id_t));
-
-//		u_lsize_t *dens = (u_lsize_t)calloc(job->graph.nof_nodes, sizeof(u_lsize_t));
-//		bool densdone = false;
+	//true if every query edge leaving qa can be mapped to an edge leaving ra
+	bool isSupported(DomainReduction& r, node_id_t qa, node_id_t ra){
+		node_id_t qb, rb;
+		bool notfound;
+		for(node_id_t i_qb=0; i_qb<mman.query.out_count[qa]; i_qb++){
+			qb = mman.query.out[qa][i_qb];
+
+			//word-wide test of the whole neighbourhood
+			if(r.out_rows[ra] != NULL){
+				if(r.out_rows[ra]->emptyAND(*r.cands[qb]))
+					return false;
+				continue;
+			}
 
-		//** global mask **//
-		sbitset target_mask;
+			notfound = true;
+			for(node_id_t i_rb=0; i_rb<r.job->graph.out_count[ra]; i_rb++){
+				rb = r.job->graph.out[ra][i_rb];
+				if( 	r.cands[qb]->get(rb)
+						//TODO
+//						&&
+//						edgeComparator.compare(mman.query.adj_attrs[qa][i_qb], job->graph.out_adj_attrs[ra][i_rb])
+				){
+					notfound = false;
+					break;
+				}
+			}
 
-		for(node_cands_t::iterator nIT = mman.gncands[job->g_id].begin();  nIT!=mman.gncands[job->g_id].end(); nIT++){
-			target_mask |= nIT->second;
+			if(notfound)
+				return false;
 		}
+		return true;
+	}
+
+	bool hasEmptyDomain(DomainReduction& r){
+		for(node_id_t q=0; q<mman.query.n; q++)
+			if(r.cands[q]->is_empty())
+				return true;
+		return false;
+	}
+
+	/* degree masking, static domain reduction and connected components on the nodes owned by @worker;
+	 * within a round, removals are computed on the domains of the previous round and applied after a barrier */
+	void reduceRange(DomainReduction& r, thread_id_t worker){
+		ReferenceGraph& graph = r.job->graph;
+		node_id_t from, to, n, ne;
+		r.workerRange(worker, from, to);
 
 		//** compute degrees of induced subgraph **//
-		node_id_t n, ne;
-		for(node_id_t n=0; n<job->graph.n; n++){
-			if(target_mask.get(n)){
-				for(node_id_t i=0; i<job->graph.out_count[n]; i++){
-					ne = job->graph.out[n][i];
-					if(target_mask.get(ne)){
-						masked_out_degree[n]++;
+		for(n=from; n<to; n++){
+			if(r.target_mask.get(n)){
+				for(node_id_t i=0; i<graph.out_count[n]; i++){
+					ne = graph.out[n][i];
+					if(r.target_mask.get(ne)){
+						r.masked_out_degree[n]++;
 					}
 				}
-				for(node_id_t i=0; i<job->graph.in_count[n]; i++){
-					ne = job->graph.in[n][i];
-					if(target_mask.get(ne)){
-						masked_in_degree[n]++;
+				for(node_id_t i=0; i<graph.in_count[n]; i++){
+					ne = graph.in[n][i];
+					if(r.target_mask.get(ne)){
+						r.masked_in_degree[n]++;
 					}
 				}
 			}
 		}
 
-		//** fix node candidates **//
-		for(node_id_t q=0; q< mman.query.n; q++){
-			for(sbitset::iterator IT =  mman.gncands[job->g_id][q].first_ones(); IT!= mman.gncands[job->g_id][q].end(); IT.next_ones()){
-				if(		masked_in_degree[IT.first] < mman.query.in_count[q]
-						||	masked_out_degree[IT.first] < mman.query.out_count[q]){
-					if(target_mask.get(IT.first)){
-						 mman.gncands[job->g_id][q].set(IT.first, false);
-					}
-				}
+		//** adjacency rows of dense nodes, testing them costs less than scanning their neighbours **//
+		const u_size_t row_blocks = graph.n / (sizeof(sbitset_block) * 8) + 1;
+		for(n=from; n<to; n++){
+			if(r.target_mask.get(n) && (u_size_t)graph.out_count[n] >= row_blocks){
+				r.out_rows[n] = new sbitset(graph.n);
+				for(node_id_t i=0; i<graph.out_count[n]; i++)
+					r.out_rows[n]->set(graph.out[n][i], true);
 			}
-			if(  mman.gncands[job->g_id][q].is_empty() )
-				return;
 		}
 
-		node_id_t ra, qb, rb;
-		bool notfound;
-		bool nextlevel = true;
-
-		//** static domains reduction **//
-		for(node_id_t qa=0; qa<mman.query.n; qa++){
-
-			for(sbitset::iterator qaIT= mman.gncands[job->g_id][qa].first_ones(); qaIT!= mman.gncands[job->g_id][qa].end(); qaIT.next_ones()){
-
-				if(		masked_in_degree[qaIT.first] < mman.query.in_count[qa]
-					||	masked_out_degree[qaIT.first] < mman.query.out_count[qa]){
-						mman.gncands[job->g_id][qa].set(qaIT.first, false);
-				}
-				else{
-					ra = qaIT.first;
-					for(node_id_t i_qb=0; i_qb<mman.query.out_count[qa]; i_qb++){
-						qb = mman.query.out[qa][i_qb];
-						notfound = true;
-
-						for(node_id_t i_rb=0; i_rb<job->graph.out_count[ra]; i_rb++){
-							rb = job->graph.out[ra][i_rb];
-							if( 	mman.gncands[job->g_id][qb].get(rb)
-									//TODO
-//									&&
-//									edgeComparator.compare(mman.query.adj_attrs[qa][i_qb], job->graph.out_adj_attrs[ra][i_rb])
-							){
-								notfound = false;
-								break;
-							}
-						}
-
-						if(notfound){
-							nextlevel = true;
-							mman.gncands[job->g_id][qa].set(ra, false);
-							break;
-						}
-					}
+		//** fix node candidates **//
+		for(node_id_t q=0; q<mman.query.n; q++){
+			for(sbitset::iterator IT = DomainReduction::firstOnes(*r.cands[q], from); IT!=r.cands[q]->end() && IT.first<to; IT.next_ones()){
+				if(		r.masked_in_degree[IT.first] < mman.query.in_count[q]
+						||	r.masked_out_degree[IT.first] < mman.query.out_count[q]){
+					r.cands[q]->set(IT.first, false);
 				}
 			}
-
-			if(mman.gncands[job->g_id][qa].is_empty())
-				return;
 		}
-
+		pthread_barrier_wait(&r.barrier);
+		if(hasEmptyDomain(r))
+			return;
 
 		//** static domain reduction until convergence **//
+		//only the candidates of query nodes with a refined successor are checked again
+		std::vector< std::pair<node_id_t, node_id_t> > removed;
+		std::vector<bool> dirty(mman.query.n, true);
+		bool* changed;
+		bool* round_changed;
+		u_size_t round = 0;
+		bool nextlevel = true;
 		while(nextlevel){
-
-			nextlevel = false;
-
-			for(int qa=0; qa<mman.query.n; qa++){
-
-				for(sbitset::iterator qaIT= mman.gncands[job->g_id][qa].first_ones(); qaIT!= mman.gncands[job->g_id][qa].end(); qaIT.next_ones()){
-					ra = qaIT.first;
-					for(node_id_t i_qb=0; i_qb<mman.query.out_count[qa]; i_qb++){
-						qb = mman.query.out[qa][i_qb];
-						notfound = true;
-
-						for(node_id_t i_rb=0; i_rb<job->graph.out_count[ra]; i_rb++){
-							rb = job->graph.out[ra][i_rb];
-							if( 	mman.gncands[job->g_id][qb].get(rb)
-									//TODO
-//									&&
-//									edgeComparator.compare(mman.query.adj_attrs[qa][i_qb], job->graph.out_adj_attrs[ra][i_rb])
-									){
-								notfound = false;
-								break;
-							}
+			round_changed = &r.worker_changed[(round % 2) * r.nworkers * mman.query.n];
+			changed = &round_changed[worker * mman.query.n];
+			round++;
+			removed.clear();
+			for(node_id_t qa=0; qa<mman.query.n; qa++)
+				changed[qa] = false;
+
+			for(node_id_t qa=0; qa<mman.query.n; qa++){
+				bool refined = false;
+				for(node_id_t i_qb=0; i_qb<mman.query.out_count[qa] && !refined; i_qb++)
+					refined = dirty[mman.query.out[qa][i_qb]];
+				if(!refined)
+					continue;
+
+				for(sbitset::iterator qaIT = DomainReduction::firstOnes(*r.cands[qa], from); qaIT!=r.cands[qa]->end() && qaIT.first<to; qaIT.next_ones()){
+					if(!isSupported(r, qa, qaIT.first)){
+						//a single thread can refine the domains in place
+						if(r.nworkers == 1){
+							r.cands[qa]->set(qaIT.first, false);
+							changed[qa] = true;
 						}
-
-						if(notfound){
-							nextlevel = true;
-							mman.gncands[job->g_id][qa].set(ra, false);
-							break;
+						else{
+							removed.push_back(std::pair<node_id_t, node_id_t>(qa, qaIT.first));
 						}
 					}
 				}
+			}
+			pthread_barrier_wait(&r.barrier);
 
-				if(mman.gncands[job->g_id][qa].is_empty())
-					return;
+			for(size_t i=0; i<removed.size(); i++){
+				r.cands[removed[i].first]->set(removed[i].second, false);
+				changed[removed[i].first] = true;
 			}
+			pthread_barrier_wait(&r.barrier);
 
+			nextlevel = false;
+			for(node_id_t q=0; q<mman.query.n; q++){
+				dirty[q] = false;
+				for(thread_id_t w=0; w<r.nworkers; w++)
+					dirty[q] = dirty[q] || round_changed[w * mman.query.n + q];
+				nextlevel = nextlevel || dirty[q];
+			}
+			if(hasEmptyDomain(r))
+				return;
 		}
 
 		//** calculate global mask **//
-		target_mask.clear(job->graph.n);
-		for(node_cands_t::iterator nIT = mman.gncands[job->g_id].begin();  nIT!=mman.gncands[job->g_id].end(); nIT++){
-			target_mask |= nIT->second;
+		for(n=from; n<to; n++){
+			bool candidate = false;
+			for(node_id_t q=0; q<mman.query.n && !candidate; q++)
+				candidate = r.cands[q]->get(n);
+			r.target_mask.set(n, candidate);
 		}
+		pthread_barrier_wait(&r.barrier);
+
+		//** retrieve connected components **//
+		for(n=from; n<to; n++){
+			if(r.target_mask.get(n)){
+				for(node_id_t i=0; i<graph.out_count[n]; i++){
+					ne = graph.out[n][i];
+					if(r.target_mask.get(ne))
+						r.unite(n, ne);
+				}
+			}
+		}
+		pthread_barrier_wait(&r.barrier);
 
+		for(n=from; n<to; n++){
+			if(r.target_mask.get(n)){
+				r.coco[n] = r.find(n);
+				__sync_fetch_and_add(&r.coco_size[r.coco[n]], 1);
+			}
+		}
+	}
 
-		//** retrieve connected components and add job to queue**//
-		bool *visited = (bool*)calloc(job->graph.n, sizeof(bool));
-		u_size_t cardinality;
-		node_id_t gn=0;
-		while(gn<job->graph.n){
-			if(!visited[gn] && target_mask.get(gn)){
-				sbitset* coco = new sbitset();
+	static void* reduceRun(void* argsptr){
+		domain_reduction_worker_t* args = (domain_reduction_worker_t*)argsptr;
+		args->reduction->ithread->reduceRange(*(args->reduction), args->worker);
+		pthread_exit(NULL);
+	}
 
-				visited[gn] = true;
-				coco->set(gn, true);
+	void fillJob(InitMatchingJob* job){
+		sbitset** cands = new sbitset*[mman.query.n];
+		for(node_id_t q=0; q<mman.query.n; q++)
+			cands[q] = &(mman.gncands[job->g_id][q]);
+
+		//** threads sharing the graph, each one owns at least a block of nodes **//
+		thread_id_t nworkers = 1;
+		if(reduction_threads > 1 && job->graph.n >= parallel_threshold){
+			const u_size_t bits = sizeof(sbitset_block) * 8;
+			nworkers = std::min<u_size_t>(reduction_threads, (job->graph.n + bits - 1) / bits);
+		}
 
-				std::stack<node_id_t> bfsqueue;
-				bfsqueue.push(gn);
+		DomainReduction r(this, job, cands, mman.query.n, nworkers);
 
-				while(!bfsqueue.empty()){
+		//** global mask **//
+		for(node_cands_t::iterator nIT = mman.gncands[job->g_id].begin();  nIT!=mman.gncands[job->g_id].end(); nIT++){
+			r.target_mask |= nIT->second;
+		}
 
-					n = bfsqueue.top();
-					bfsqueue.pop();
+		pthread_t* workers = new pthread_t[nworkers];
+		domain_reduction_worker_t* args = new domain_reduction_worker_t[nworkers];
+		int rc;
+		for(thread_id_t w=1; w<nworkers; w++){
+			args[w].reduction = &r;
+			args[w].worker = w;
+			rc = pthread_create(&workers[w], NULL, InitMatchingThread::reduceRun, (void*)&args[w]);
+			if(rc){
+				printf("ERROR; return code from pthread_create() is %d\n", rc);
+				exit(-1);
+			}
+		}
+		reduceRange(r, 0);
+		for(thread_id_t w=1; w<nworkers; w++){
+			rc = pthread_join(workers[w], NULL);
+			if(rc){
+				printf("ERROR; return code from pthread_join() is %d\n", rc);
+				exit(-1);
+			}
+		}
+		delete [] workers;
+		delete [] args;
 
-					for(node_id_t i=0; i<job->graph.out_count[n]; i++){
-						ne = job->graph.out[n][i];
-						if(!visited[ne] && target_mask.get(ne)){
-								bfsqueue.push(ne);
-								visited[ne] = true;
-								coco->set(ne, true);
-//							}
-						}
-					}
-					for(node_id_t i=0; i<job->graph.in_count[n]; i++){
-						ne = job->graph.in[n][i];
-						if(!visited[ne] && target_mask.get(ne)){
-								bfsqueue.push(ne);
-								visited[ne] = true;
-								coco->set(ne, true);
-//							}
-						}
-					}
-				}
+		if(!hasEmptyDomain(r))
+			addComponentJobs(r);
 
-				cardinality = coco->cardinality();
+		delete [] cands;
+	}
 
-				//** decompose connected components into sub-tasks **//
-				if(cardinality >= query_size){
+	//** decompose connected components into sub-tasks and add them to the job **//
+	void addComponentJobs(DomainReduction& r){
+		InitMatchingJob* job = r.job;
 
-					mman.number_of_cocos[id] += 1;
+		//components large enough to hold the query, ordered by their smallest node
+		std::vector< std::vector<node_id_t> > cocos;
+		//the forest is no longer needed, its entries are reused for the index of each root
+		node_id_t* coco_index = r.parent;
+		for(node_id_t n=0; n<job->graph.n; n++){
+			if(r.target_mask.get(n) && r.coco_size[r.coco[n]] >= query_size){
+				if(r.coco[n] == n){
+					coco_index[n] = cocos.size();
+					cocos.push_back(std::vector<node_id_t>());
+				}
+				cocos[coco_index[r.coco[n]]].push_back(n);
+			}
+		}
 
-					//TODO
-					//push job (connected component)
-					//job->cocos.push_front(match_job_t(*coco));
+		for(size_t c=0; c<cocos.size(); c++){
+			std::vector<node_id_t>& coco = cocos[c];
 
-					//search the max dom node d inside the coco
-					//get the diameter D of d
-					//consider only targets of dom(d) inside the coco
-					//for each target
-					//  make a partition with just one core node
-					//  extend the frontier of the partition by a bfs of length D
+			mman.number_of_cocos[id] += 1;
 
+			//TODO
+			//push job (connected component)
+			//job->cocos.push_front(match_job_t(*coco));
 
-					u_size_t max_card_value = 0;
-					node_id_t max_card_node = -1;
+			//search the max dom node d inside the coco
+			//get the diameter D of d
+			//consider only targets of dom(d) inside the coco
+			//for each target
+			//  make a partition with just one core node
+			//  extend the frontier of the partition by a bfs of length D
 
-					u_size_t min_card_value = 0;
-					node_id_t min_card_node = -1;
 
-					u_size_t c_card;
-					for(node_id_t qa=0; qa<mman.query.NodeCount(); qa++){
+			u_size_t max_card_value = 0;
+			node_id_t max_card_node = -1;
 
-						c_card = 0;
-						for(sbitset::iterator qaIT= mman.gncands[job->g_id][qa].first_ones(); qaIT!= mman.gncands[job->g_id][qa].end(); qaIT.next_ones()){
-							ra = qaIT.first;
-							if(coco->get(ra)){
-								c_card++;
-							}
-						}
+			u_size_t min_card_value = 0;
+			node_id_t min_card_node = -1;
 
-						if(c_card <= nthreads){
-							if(max_card_value == 0 ||
-								c_card > max_card_value ||
-								( c_card == max_card_value && mman.query.EdgeCount(qa) > mman.query.EdgeCount(max_card_node) )
-							){
-								max_card_value = c_card;
-								max_card_node =qa;
-							}
-						}
-						else{
-							if(min_card_value == 0 ||
-								c_card < min_card_value ||
-								( c_card == min_card_value && mman.query.EdgeCount(qa) > mman.query.EdgeCount(min_card_node) )
-							){
-								min_card_value = c_card;
-								min_card_node =qa;
-							}
-						}
+			u_size_t c_card;
+			for(node_id_t qa=0; qa<mman.query.NodeCount(); qa++){
 
+				c_card = 0;
+				for(size_t i=0; i<coco.size(); i++){
+					if(r.cands[qa]->get(coco[i])){
+						c_card++;
 					}
+				}
 
-					if(max_card_value == 1 || max_card_value == 0){
-						if(min_card_node != -1){
-							max_card_value = min_card_value;
-							max_card_node = min_card_node;
-						}
+				if(c_card <= nthreads){
+					if(max_card_value == 0 ||
+						c_card > max_card_value ||
+						( c_card == max_card_value && mman.query.EdgeCount(qa) > mman.query.EdgeCount(max_card_node) )
+					){
+						max_card_value = c_card;
+						max_card_node =qa;
 					}
-					//consider only targets of dom(d) inside the coco
-					//for each target
-					//  make a partition with just one core node
-					for(sbitset::iterator qaIT= mman.gncands[job->g_id][max_card_node].first_ones()
-							; qaIT!= mman.gncands[job->g_id][max_card_node].end(); qaIT.next_ones()){
-						ra = qaIT.first;
-						if(coco->get(ra)){
-							job->cocos.push_front(match_job_t(ra, max_card_node));
-						}
+				}
+				else{
+					if(min_card_value == 0 ||
+						c_card < min_card_value ||
+						( c_card == min_card_value && mman.query.EdgeCount(qa) > mman.query.EdgeCount(min_card_node) )
+					){
+						min_card_value = c_card;
+						min_card_node =qa;
 					}
+				}
+
+			}
 
+			if(max_card_value == 1 || max_card_value == 0){
+				if(min_card_node != -1){
+					max_card_value = min_card_value;
+					max_card_node = min_card_node;
+				}
+			}
+			//consider only targets of dom(d) inside the coco
+			//for each target
+			//  make a partition with just one core node
+			for(size_t i=0; i<coco.size(); i++){
+				if(r.cands[max_card_node]->get(coco[i])){
+					job->cocos.push_front(match_job_t(coco[i], max_card_node));
 				}
-				delete coco;
 			}
-			gn++;
 		}
-
-		free(visited);
-		free(masked_in_degree);
-		free(masked_out_degree);
-//		free(dens);
 	}
 
 
@@ -368,11 +536,29 @@ public:
 	thread_id_t id;
 	MatchListener& mlistener;
 	ARGEdit& equery;
-	bool first_match;
 	AttributeComparator& edgeComparator;//TODO NOT USED
 
 	MPRINT_OPTIONS mprint_opt;
 
+	//it reduces the candidates of a graph in pipelined runs, it is NULL otherwise
+	InitMatchingThread* init_thread;
+
+	//** task splitting **//
+	//states visited by the current task
+	u_lsize_t task_states;
+	//a task visiting more states than this is split, if some thread is idle
+	u_lsize_t split_threshold;
+	//subtasks are only split up to this number of pairs after the pivot
+	u_size_t split_depth;
+
+	//target node of each query node in the current state, to check the symmetry breaking conditions
+	node_id* query_map;
+
+	//matches found in the graph of the current task, if they are limited per graph
+	volatile u_lsize_t* graph_matches;
+	//states visited between two checks of the time budget
+	u_lsize_t deadline_period;
+
 	MatchingThread(	MatchingManager& _mman,
 					thread_id_t _id,
 					std::ostream& outstream,
@@ -386,103 +572,178 @@ public:
 			  mlistener(_mlistener),
 			  edgeComparator(_edgeComparator),
 			  mprint_opt(_mprint_opt){
-		first_match = true;
+		graph_matches = NULL;
+		deadline_period = 1024;
+		init_thread = NULL;
+		task_states = 0;
+		split_threshold = 1024;
+		split_depth = 3;
+		query_map = NULL;
+	}
+
+	/* depth-first visit of the matches from state s, as vflib's match does,
+	 * extending and backtracking s in place instead of cloning it at each level;
+	 * task.prefix holds the pairs added after the pivot to reach s.
+	 * Any engine state providing vflib's State methods, UndoPair and Reset can be visited.
+	 * It returns true when the visit has to stop, because enough matches have been found */
+	template<class EngineState>
+	bool visit(EngineState* s, node_id c1[], node_id c2[], g_match_task_t& task){
+		if(s->IsGoal()){
+			if(!mman.claimMatch(graph_matches))
+				return true;
+			int n = s->CoreLen();
+			s->GetCoreSet(c1, c2);
+			my_visitor(n, c1, c2, &mlistener);
+			return mman.enoughMatches(graph_matches);
+		}
+		if(s->IsDead())
+			return false;
+
+		task_states++;
+		//the clock is read every deadline_period states
+		if(mman.deadline != NULL && (task_states % deadline_period) == 0 && mman.deadline->passed())
+			return true;
+
+		bool stop = false;
+		node_id n1=NULL_NODE, n2=NULL_NODE;
+		while(!stop && s->NextPair(&n1, &n2, n1, n2)){
+			if(s->IsFeasiblePair(n1, n2)
+					&& (mman.symmetries == NULL || mman.symmetries->allows(n1, n2, query_map))){
+				task.prefix.push_back(std::pair<node_id_t, node_id_t>(n1, n2));
+
+				//expensive tasks hand their shallow subtrees over to idle threads
+				if(task_states > split_threshold && task.prefix.size() <= split_depth && mman.hasIdleThreads()){
+					mman.syncPushMatchJob(id, task);
+				}
+				else{
+					s->AddPair(n1, n2);
+					query_map[n1] = n2;
+					//matches found by other threads, and their timeouts, stop this visit too
+					stop = visit(s, c1, c2, task) || mman.enoughMatches(graph_matches) || mman.timedOut();
+					query_map[n1] = NULL_NODE;
+					s->UndoPair();
+				}
+
+				task.prefix.pop_back();
+			}
+		}
+		return stop;
+	}
+
+	//VF2 reads the domains through the node comparator of the query
+	VF2MonoState* resetState(VF2MonoState* s, QueryGraph& query, sbitset* domains, ReferenceGraph* graph){
+		if(s == NULL)
+			return new VF2MonoState(&query, graph);
+		s->Reset(graph);
+		return s;
+	}
+
+	rilib::RIState* resetState(rilib::RIState* s, QueryGraph& query, sbitset* domains, ReferenceGraph* graph){
+		if(s == NULL)
+			return new rilib::RIState(&query, graph, domains);
+		s->Reset(graph, domains);
+		return s;
+	}
+
+	//the state of the engine is created by the first task, and reset for the graph of the next ones
+	template<class EngineState>
+	void matchTask(EngineState*& s0, QueryGraph& query, sbitset* domains, node_id c1[], node_id c2[], g_match_task_t& task){
+		s0 = resetState(s0, query, domains, mman.graphs[task.first]);
+
+		//query node: task.second.second
+		//target node: task.second.first
+		//pairs of split tasks are replayed from the pivot, they were feasible in the same state
+		s0->AddPair(task.second.second, task.second.first);
+		query_map[task.second.second] = task.second.first;
+		for(match_prefix_t::iterator IT = task.prefix.begin(); IT!=task.prefix.end(); IT++){
+			s0->AddPair(IT->first, IT->second);
+			query_map[IT->first] = IT->second;
+		}
+
+		task_states = 0;
+		visit(s0, c1, c2, task);
+		//the state is left empty, with clean vectors for the next task
+		for(size_t i=0; i<=task.prefix.size(); i++)
+			s0->UndoPair();
+		for(int i=0; i<query.NodeCount(); i++)
+			query_map[i] = NULL_NODE;
 	}
 
 	static void* run(void* argsptr){
 			MatchingThread* mt = (MatchingThread*)argsptr;
 
-			MatchingJob* job;
+			g_match_task_t task;
 
 			QueryGraph query(&(mt->equery));
 			VF2DSAttrComparator* attrComp = new VF2DSAttrComparator();
 			query.SetNodeComparator(attrComp);
 
 			sbitset* domains = new sbitset[query.NodeCount()];
+			node_id* c1 = new node_id[query.NodeCount()];
+			node_id* c2 = new node_id[query.NodeCount()];
+			mt->query_map = new node_id[query.NodeCount()];
+			for(int i=0; i<query.NodeCount(); i++)
+				mt->query_map[i] = NULL_NODE;
+			//search states reused by every task of this thread, one per engine
+			VF2MonoState* vf2_state = NULL;
+			rilib::RIState* ri_state = NULL;
+
+			InitMatchingJob* ijob;
+
+			while(true){
+				//tasks of the graphs reduced by this thread come first, then new graphs to reduce, then stolen tasks
+				if(!mt->mman.popAMatchJob(mt->id, task)){
+					if(mt->init_thread != NULL && mt->mman.syncGetAInitJob(mt->id, &ijob)){
+						mt->init_thread->fillJob(ijob);
+						mt->mman.syncFinishInitJob(mt->id, ijob);
+						delete ijob;
+						continue;
+					}
+					if(!mt->mman.syncGetAMatchJob(mt->id, task))
+						break;
+				}
 
-//			graph_id_t p_gid = graph_id_t_MAX;
-//			node_id_t p_pnodeid = node_id_t_MAX;
-
-
-			while(mt->mman.syncGetAMatchJob(mt->id, &job)){
-
-//				if(p_gid == graph_id_t_MAX ||  (job->coco.first != p_gid) || (job->coco.second.second != p_pnodeid)){
-//
-//					if(p_gid != graph_id_t_MAX){
-//						delete[] domains;
-//						domains = new sbitset[query.NodeCount()];
-//					}
-//
-//
-//
-//					for(int i=0; i<query.NodeCount(); i++){
-//						domains[i].warp(mt->mman.gncands[job->coco.first][i]);
-//					}
-//				}
+				//tasks of a graph, or of the whole run, that already has enough matches are skipped, as every task after the time budget
+				mt->graph_matches = mt->mman.graphMatches(task.first);
+				if(mt->mman.enoughMatches(mt->graph_matches) || (mt->mman.deadline != NULL && mt->mman.deadline->passed())){
+					mt->mman.number_of_skips[mt->id]++;
+					mt->mman.syncFinishMatchJob(mt->id);
+					continue;
+				}
 
 				for(int i=0; i<query.NodeCount(); i++){
-					domains[i].warp(mt->mman.gncands[job->coco.first][i]);
+					domains[i].warp(mt->mman.gncands[task.first][i]);
 				}
 
 				attrComp->domains = domains;
-				//attrComp->coco_mask = &(job->coco.second);
-//
-//				p_gid = job->coco.first;
-//				p_pnodeid = job->coco.second.second;
-//
+
 				mt->mlistener.matchcount = 0;
-				mt->mlistener.gid = job->coco.first;
-//
-//
-//				std::cout<<"("<<job->coco.second.second<<","<<job->coco.second.first<<"):"<<domains[job->coco.second.second].get(job->coco.second.first)<<"\n";
-//				//query node: job->coco.second.second
-//				//target node: job->coco.second.first
-//
-				State* s0 = new VF2MonoState(&(query), (mt->mman.graphs[job->coco.first]));
-				matchFrom(s0, my_visitor, &(mt->mlistener),   job->coco.second.second, job->coco.second.first );
-				delete s0;
-//
-//
+				mt->mlistener.gid = task.first;
+
+				if(mt->mman.engine == MATCH_ENGINE_RI)
+					mt->matchTask(ri_state, query, domains, c1, c2, task);
+				else
+					mt->matchTask(vf2_state, query, domains, c1, c2, task);
+
+				//each match satisfying the symmetry breaking conditions stands for |Aut(Q)| matches
+				if(mt->mman.symmetries != NULL)
+					mt->mlistener.matchcount *= mt->mman.symmetries->automorphisms;
 				mt->mman.number_of_matches[mt->id] += mt->mlistener.matchcount;
 				if(mt->mlistener.matchcount > 0)
-					mt->mman.matching_graphs[mt->id].insert(job->coco.first);
+					mt->mman.matching_graphs[mt->id].insert(task.first);
+				//a task interrupted by the time budget is partially verified
+				if(!mt->mman.timedOut())
+					mt->mman.number_of_verified[mt->id]++;
+
+				mt->mman.syncFinishMatchJob(mt->id);
 			}
 
+			delete vf2_state;
+			delete ri_state;
 			delete[] domains;
-
-
-
-//			sbitset* domains = new sbitset[query.n];
-//
-//			while(mt->mman.syncGetAMatchJob(mt->id, &job)){
-//
-////				delete[] domains;
-////				domains = new sbitset[query.n];
-//				for(int i=0; i<query.n; i++){
-//					domains[i].warp(mt->mman.gncands[job->coco.first][i]);
-//				}
-//
-//				attrComp->domains = domains;
-//				attrComp->coco_mask = &(job->coco.second);
-//
-//
-//				mt->mlistener.matchcount = 0;
-//				mt->mlistener.gid = job->coco.first;
-//
-//
-//				State* s0 = new VF2MonoState(&(query), (mt->mman.graphs[job->coco.first]));
-//				match(s0, my_visitor, &(mt->mlistener) );
-//
-//
-//				mt->mman.number_of_matches[mt->id] += mt->mlistener.matchcount;
-//					if(mt->mlistener.matchcount > 0)
-//						mt->mman.matching_graphs[mt->id].insert(job->coco.first);
-//
-//
-//			}
-//
-//			delete[] domains;
-
+			delete[] c1;
+			delete[] c2;
+			delete[] mt->query_map;
 
 			pthread_exit(NULL);
 	}
@@ -0,0 +1,188 @@
+/*
+ * MatchingOrder.h
+ *
+ * Static matching order of a query graph, RI style.
+ */
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RI_MATCHINGORDER_H_
+#define RI_MATCHINGORDER_H_
+
+#include <vector>
+#include <utility>
+
+#include "argraph.h"
+
+namespace rilib{
+
+/*
+ * Query nodes in the order they are matched. The node at position i > 0 has a parent,
+ * an earlier neighbour: its candidates are the neighbours of the target node matched to the parent.
+ * The edges towards the other earlier neighbours are checked on each candidate.
+ */
+class MatchingOrder{
+public:
+	//query node at each position
+	std::vector<node_id> order;
+	//position of the parent of each position, -1 if the node is not connected to the earlier ones
+	std::vector<int> parent;
+	//true if the candidates are the out-neighbours of the parent's target, false for the in-neighbours
+	std::vector<bool> parent_out;
+	/* earlier neighbours of each position, with the direction of the edge:
+	 * true for an edge from the node to the neighbour, false for the opposite one */
+	std::vector< std::vector< std::pair<node_id, bool> > > checks;
+	//true if the node at each position has a self loop
+	std::vector<bool> self_loop;
+
+	/* GreatestConstraintFirst: after @start, each step takes the node with more earlier neighbours,
+	 * then with more neighbours shared with the earlier ones, then with higher degree;
+	 * ties go to the node with fewer candidates, as given by @domain_sizes */
+	void build(Graph* query, node_id start, const std::vector<int>& domain_sizes){
+		int n = query->NodeCount();
+		std::vector<bool> ordered(n, false);
+		//number of earlier neighbours of each node, each neighbour counted once
+		std::vector<int> vis(n, 0);
+		//neighbours of the earlier nodes
+		std::vector<bool> frontier(n, false);
+
+		order.clear();
+		parent.clear();
+		parent_out.clear();
+		checks.clear();
+		self_loop.clear();
+
+		node_id next = start;
+		for(int i=0; i<n; i++){
+			if(i > 0){
+				int best = -1;
+				int best_vis = 0, best_neig = 0, best_deg = 0;
+				for(int u=0; u<n; u++){
+					if(ordered[u])
+						continue;
+					int neig = 0;
+					std::vector<node_id> neighbours;
+					neighboursOf(query, u, neighbours);
+					for(size_t j=0; j<neighbours.size(); j++)
+						if(!ordered[neighbours[j]] && frontier[neighbours[j]])
+							neig++;
+					int deg = neighbours.size();
+
+					if(best == -1
+							|| vis[u] > best_vis
+							|| (vis[u] == best_vis && neig > best_neig)
+							|| (vis[u] == best_vis && neig == best_neig && deg > best_deg)
+							|| (vis[u] == best_vis && neig == best_neig && deg == best_deg && domain_sizes[u] < domain_sizes[best])){
+						best = u;
+						best_vis = vis[u];
+						best_neig = neig;
+						best_deg = deg;
+					}
+				}
+				next = best;
+			}
+
+			add(query, next, ordered);
+
+			ordered[next] = true;
+			std::vector<node_id> neighbours;
+			neighboursOf(query, next, neighbours);
+			for(size_t j=0; j<neighbours.size(); j++){
+				vis[neighbours[j]]++;
+				frontier[neighbours[j]] = true;
+			}
+		}
+	}
+
+private:
+	//distinct neighbours of @u, both directions, without @u itself
+	static void neighboursOf(Graph* query, node_id u, std::vector<node_id>& neighbours){
+		std::vector<bool> seen(query->NodeCount(), false);
+		seen[u] = true;
+		for(int i=0; i<query->OutEdgeCount(u); i++){
+			node_id v = query->GetOutEdge(u, i);
+			if(!seen[v]){
+				seen[v] = true;
+				neighbours.push_back(v);
+			}
+		}
+		for(int i=0; i<query->InEdgeCount(u); i++){
+			node_id v = query->GetInEdge(u, i);
+			if(!seen[v]){
+				seen[v] = true;
+				neighbours.push_back(v);
+			}
+		}
+	}
+
+	void add(Graph* query, node_id u, const std::vector<bool>& ordered){
+		std::vector< std::pair<node_id, bool> > edges;
+		int parent_pos = -1;
+		bool out = true;
+
+		for(int i=0; i<query->OutEdgeCount(u); i++){
+			node_id v = query->GetOutEdge(u, i);
+			if(v != u && ordered[v])
+				edges.push_back(std::pair<node_id, bool>(v, true));
+		}
+		for(int i=0; i<query->InEdgeCount(u); i++){
+			node_id v = query->GetInEdge(u, i);
+			if(v != u && ordered[v])
+				edges.push_back(std::pair<node_id, bool>(v, false));
+		}
+
+		//the earliest neighbour is the parent, its edge is implied by the candidate generation
+		size_t parent_edge = edges.size();
+		for(size_t j=0; j<edges.size(); j++){
+			int pos = position(edges[j].first);
+			if(parent_pos == -1 || pos < parent_pos){
+				parent_pos = pos;
+				parent_edge = j;
+			}
+		}
+		if(parent_edge < edges.size()){
+			//an edge u -> parent means the candidates are the in-neighbours of the parent's target
+			out = !edges[parent_edge].second;
+			edges.erase(edges.begin() + parent_edge);
+		}
+
+		order.push_back(u);
+		parent.push_back(parent_pos);
+		parent_out.push_back(out);
+		checks.push_back(edges);
+		self_loop.push_back(query->HasEdge(u, u));
+	}
+
+	int position(node_id u) const{
+		for(size_t i=0; i<order.size(); i++)
+			if(order[i] == u)
+				return i;
+		return -1;
+	}
+};
+
+}
+
+#endif /* RI_MATCHINGORDER_H_ */
@@ -0,0 +1,282 @@
+/*
+ * RIState.h
+ *
+ * State of an RI-style subgraph monomorphism search, driven by a static matching order
+ * and by the candidate domains of the query nodes.
+ */
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RI_RISTATE_H_
+#define RI_RISTATE_H_
+
+#include <assert.h>
+#include <vector>
+
+#include "argraph.h"
+#include "state.h"
+#include "sbitset.h"
+
+#include "MatchingOrder.h"
+
+namespace rilib{
+
+/*
+ * Unlike VF2, the next query node does not depend on the state: the nodes are matched
+ * following the order built for the first one, and the candidates of a node are the
+ * neighbours of its parent's target, filtered by the node's domain.
+ * The state is meant to be extended and backtracked in place (AddPair/UndoPair),
+ * and reused for other targets (Reset); as a vflib State, clones share its vectors.
+ */
+class RIState : public State{
+	Graph *g1, *g2;
+	int n1, n2;
+	int core_len, orig_core_len;
+
+	node_id *core_1;
+	node_id *core_2;
+	//index of the last candidate tried at each position, in its parent's adjacency list
+	int *cursor;
+	//number of target nodes core_2 has room for
+	int max_n2;
+
+	//orders starting from each query node, built when first needed for the current target
+	MatchingOrder *orders;
+	bool *order_built;
+	MatchingOrder *mo;
+
+	long *share_count;
+
+public:
+	//candidates of each query node
+	sbitset* domains;
+
+	RIState(Graph *ag1, Graph *ag2, sbitset* _domains)
+			: g1(ag1), g2(ag2), domains(_domains){
+		n1 = g1->NodeCount();
+		n2 = g2->NodeCount();
+		max_n2 = n2;
+		core_len = orig_core_len = 0;
+
+		core_1 = new node_id[n1];
+		core_2 = new node_id[n2];
+		cursor = new int[n1];
+		orders = new MatchingOrder[n1];
+		order_built = new bool[n1];
+		for(int i=0; i<n1; i++){
+			core_1[i] = NULL_NODE;
+			order_built[i] = false;
+		}
+		for(int i=0; i<n2; i++)
+			core_2[i] = NULL_NODE;
+		mo = NULL;
+
+		share_count = new long;
+		*share_count = 1;
+	}
+
+	//clones share the vectors of the state and start from its current core
+	RIState(const RIState& state)
+			: State(), g1(state.g1), g2(state.g2), n1(state.n1), n2(state.n2),
+			  core_len(state.core_len), orig_core_len(state.core_len),
+			  core_1(state.core_1), core_2(state.core_2), cursor(state.cursor), max_n2(state.max_n2),
+			  orders(state.orders), order_built(state.order_built), mo(state.mo),
+			  share_count(state.share_count), domains(state.domains){
+		++ *share_count;
+	}
+
+	~RIState(){
+		if(-- *share_count == 0){
+			delete [] core_1;
+			delete [] core_2;
+			delete [] cursor;
+			delete [] orders;
+			delete [] order_built;
+			delete share_count;
+		}
+	}
+
+	Graph *GetGraph1(){ return g1; }
+	Graph *GetGraph2(){ return g2; }
+	bool IsGoal(){ return core_len == n1; }
+	bool IsDead(){ return n1 > n2; }
+	int CoreLen(){ return core_len; }
+
+	bool NextPair(node_id *pn1, node_id *pn2, node_id /*prev_n1*/=NULL_NODE, node_id prev_n2=NULL_NODE){
+		if(core_len == 0)
+			useOrder(firstNode());
+		node_id u = mo->order[core_len];
+		int p = mo->parent[core_len];
+		int c = (prev_n2 == NULL_NODE) ? 0 : cursor[core_len] + 1;
+		node_id v;
+
+		if(p == -1){
+			//no earlier neighbour: every candidate of the node, by increasing id
+			for(v=c; v<n2; v++){
+				if(core_2[v] == NULL_NODE && domains[u].get(v))
+					break;
+			}
+			if(v >= n2)
+				return false;
+			cursor[core_len] = v;
+		}
+		else{
+			node_id pv = core_1[mo->order[p]];
+			int count = mo->parent_out[core_len] ? g2->OutEdgeCount(pv) : g2->InEdgeCount(pv);
+			for(; c<count; c++){
+				v = mo->parent_out[core_len] ? g2->GetOutEdge(pv, c) : g2->GetInEdge(pv, c);
+				if(core_2[v] == NULL_NODE && domains[u].get(v))
+					break;
+			}
+			if(c >= count)
+				return false;
+			cursor[core_len] = c;
+		}
+
+		*pn1 = u;
+		*pn2 = v;
+		return true;
+	}
+
+	bool IsFeasiblePair(node_id node1, node_id node2){
+		assert(node1 < n1);
+		assert(node2 < n2);
+
+		if(core_2[node2] != NULL_NODE || !domains[node1].get(node2))
+			return false;
+		if(g2->OutEdgeCount(node2) < g1->OutEdgeCount(node1) || g2->InEdgeCount(node2) < g1->InEdgeCount(node1))
+			return false;
+		//the first pair chooses the order
+		if(core_len == 0)
+			return true;
+
+		if(mo->self_loop[core_len] && !g2->HasEdge(node2, node2))
+			return false;
+
+		const std::vector< std::pair<node_id, bool> >& checks = mo->checks[core_len];
+		for(size_t i=0; i<checks.size(); i++){
+			node_id other2 = core_1[checks[i].first];
+			if(checks[i].second ? !g2->HasEdge(node2, other2) : !g2->HasEdge(other2, node2))
+				return false;
+		}
+		return true;
+	}
+
+	//pairs after the first one must follow the order, as NextPair does
+	void AddPair(node_id node1, node_id node2){
+		assert(core_len < n1);
+		if(core_len == 0)
+			useOrder(node1);
+		assert(mo->order[core_len] == node1);
+
+		core_1[node1] = node2;
+		core_2[node2] = node1;
+		core_len++;
+	}
+
+	//it undoes the last pair added, at any depth
+	void UndoPair(){
+		assert(core_len > 0);
+		core_len--;
+		node_id node1 = mo->order[core_len];
+		core_2[core_1[node1]] = NULL_NODE;
+		core_1[node1] = NULL_NODE;
+		orig_core_len = core_len;
+	}
+
+	void BackTrack(){
+		if(orig_core_len < core_len)
+			UndoPair();
+	}
+
+	void GetCoreSet(node_id c1[], node_id c2[]){
+		int i, j;
+		for(i=0, j=0; i<n1; i++)
+			if(core_1[i] != NULL_NODE){
+				c1[j] = i;
+				c2[j] = core_1[i];
+				j++;
+			}
+	}
+
+	State *Clone(){
+		return new RIState(*this);
+	}
+
+	/* it reuses the vectors of an empty state for another target, with the candidates in @_domains;
+	 * orders are rebuilt only when the target changes */
+	void Reset(Graph *ag2, sbitset* _domains){
+		assert(core_len == 0);
+		assert(*share_count == 1);
+
+		if(ag2 != g2){
+			for(int i=0; i<n1; i++)
+				order_built[i] = false;
+			mo = NULL;
+		}
+		g2 = ag2;
+		n2 = g2->NodeCount();
+		domains = _domains;
+
+		if(n2 > max_n2){
+			delete [] core_2;
+			core_2 = new node_id[n2];
+			for(int i=0; i<n2; i++)
+				core_2[i] = NULL_NODE;
+			max_n2 = n2;
+		}
+		orig_core_len = 0;
+	}
+
+private:
+	//without a given first pair, the search starts from the node with fewer candidates
+	node_id firstNode(){
+		node_id first = 0;
+		u_size_t first_size = 0;
+		for(int i=0; i<n1; i++){
+			u_size_t size = domains[i].cardinality();
+			if(i == 0 || size < first_size){
+				first = i;
+				first_size = size;
+			}
+		}
+		return first;
+	}
+
+	void useOrder(node_id start){
+		if(!order_built[start]){
+			std::vector<int> domain_sizes(n1);
+			for(int i=0; i<n1; i++)
+				domain_sizes[i] = domains[i].cardinality();
+			orders[start].build(g1, start, domain_sizes);
+			order_built[start] = true;
+		}
+		mo = &orders[start];
+	}
+};
+
+}
+
+#endif /* RI_RISTATE_H_ */
@@ -142,7 +142,7 @@ class ARGraph_impl
 
 
     public:
-      typedef short count_type;
+      typedef int count_type;
 
       int n;              /* number of nodes  */
       void* *attr;        /* node attributes  */
@@ -158,6 +158,14 @@ class ARGraph_impl
       AttrComparator *node_comparator; // Used to test node attr. compat.
       AttrComparator *edge_comparator; // Used to test edge attr. compat.
 
+      /* Constant time edge test, built by BuildEdgeIndex once the
+       * edges are final: a bit matrix for small or dense graphs,
+       * a hash set of the edges for the others */
+      unsigned int *edge_bits;   /* adjacency rows, edge_row_words each */
+      int edge_row_words;
+      unsigned int *edge_hash;   /* open addressing, (n1<<16)|n2 keys */
+      int edge_hash_shift;       /* 32 - log2 of the table size */
+
 
 
 
@@ -186,6 +194,8 @@ class ARGraph_impl
 
       bool HasEdge(node_id n1, node_id n2);
       bool HasEdge(node_id n1, node_id n2, void **pattr);
+      bool HasEdgeComparator();
+      void BuildEdgeIndex();
       void *GetEdgeAttr(node_id n1, node_id n2);
       void SetEdgeAttr(node_id n1, node_id n2, void *attr, 
                        bool destroyOld=false);
@@ -209,6 +219,9 @@ class ARGraph_impl
     protected:
       virtual void DestroyNode(void *attr);
       virtual void DestroyEdge(void *attr);
+
+    private:
+      bool HasHashedEdge(node_id n1, node_id n2);
   };
 
 /*
@@ -337,7 +350,36 @@ inline void * ARGraph_impl::GetNodeAttr(node_id i)
  * Check the presence of an edge
  ---------------------------------------------*/
 inline bool ARGraph_impl::HasEdge(node_id n1, node_id n2)
-    { return HasEdge(n1, n2, NULL);
+    { assert(n1<n);
+      assert(n2<n);
+      if (edge_bits!=NULL)
+        return (edge_bits[n1*edge_row_words+(n2>>5)]>>(n2&31)) & 1;
+      if (edge_hash!=NULL)
+        return HasHashedEdge(n1, n2);
+      return HasEdge(n1, n2, NULL);
+    }
+
+/*----------------------------------------------
+ * Looks an edge up in the hash set of the edges
+ ---------------------------------------------*/
+inline bool ARGraph_impl::HasHashedEdge(node_id n1, node_id n2)
+    { unsigned int key=((unsigned int)n1<<16)|n2;
+      unsigned int mask=(1u<<(32-edge_hash_shift))-1;
+      unsigned int h=(key*2654435761u)>>edge_hash_shift;
+      while (edge_hash[h]!=key)
+        { if (edge_hash[h]==0xFFFFFFFFu)
+            return false;
+          h=(h+1)&mask;
+        }
+      return true;
+    }
+
+/*----------------------------------------------
+ * False if every pair of edges is compatible,
+ * so that their attributes need not be read
+ ---------------------------------------------*/
+inline bool ARGraph_impl::HasEdgeComparator()
+    { return edge_comparator!=NULL;
     }
 
 /*----------------------------------------------
@@ -39,4 +39,9 @@ int match(State *s0, match_visitor vis, void *usr_data=NULL);
 
 int matchFrom(State *s0, match_visitor vis, void *usr_data, node_id qnode, node_id tnode);
 
+/* as above, with the c1 and c2 arrays provided by the caller
+ * (at least as large as the larger graph), to be reused across calls */
+int matchFrom(State *s0, match_visitor vis, void *usr_data, node_id qnode, node_id tnode,
+              node_id c1[], node_id c2[]);
+
 #endif
@@ -45,6 +45,17 @@ class VF2MonoState: public State
       int n1, n2;
 
 	  long *share_count;
+
+      /* undo log of the pairs added so far, one entry per level:
+       * the query node added and the lengths of the terminal sets before it */
+      struct UndoEntry
+        { node_id node1;
+          int t1both_len, t2both_len, t1in_len, t1out_len,
+              t2in_len, t2out_len;
+        };
+      UndoEntry *undo_log;
+      // number of target nodes the vectors have room for
+      int max_n2;
     
     public:
       VF2MonoState(Graph *g1, Graph *g2, bool sortNodes=false);
@@ -67,6 +78,11 @@ class VF2MonoState: public State
       State *Clone();
 
       virtual void BackTrack();
+
+      // Undoes the last pair added in place, at any depth
+      void UndoPair();
+      // Reuses the vectors of an empty state for another target graph
+      void Reset(Graph *ag2);
   };
 
 
@@ -66,6 +66,10 @@ ARGraph_impl::ARGraph_impl(){
 	out_count = NULL; /* number of 'out edges for each node */
 	out = NULL;      /* nodes connected by 'out' edges to each node */
 	out_attr = NULL;   /* Edge attributes for 'out' edges */
+	edge_bits = NULL;
+	edge_row_words = 0;
+	edge_hash = NULL;
+	edge_hash_shift = 0;
 }
 
 ARGraph_impl::ARGraph_impl(ARGLoader *loader)
@@ -73,6 +77,10 @@ ARGraph_impl::ARGraph_impl(ARGLoader *loader)
     edge_destroyer=NULL;
     node_comparator=NULL;
     edge_comparator=NULL;
+    edge_bits=NULL;
+    edge_row_words=0;
+    edge_hash=NULL;
+    edge_hash_shift=0;
     n = loader->NodeCount();
     attr = new void*[n];
     ptrcheck(attr);
@@ -300,6 +308,54 @@ bool ARGraph_impl::HasEdge(node_id n1, node_id n2, void **pattr)
     return false;
   }
 
+/*-------------------------------------------------------------------
+ * Builds the index used by HasEdge(n1, n2) to test an edge in
+ * constant time. The edges must not change afterwards.
+ * Graphs with few nodes, or dense enough that the bit matrix
+ * takes at most eight words per edge, get the bit matrix;
+ * the others get a hash set with a load factor of at most 1/2.
+ ------------------------------------------------------------------*/
+void ARGraph_impl::BuildEdgeIndex()
+  { int i, j;
+    long edges=0;
+    for(i=0; i<n; i++)
+      edges+=out_count[i];
+
+    delete[] edge_bits;
+    delete[] edge_hash;
+    edge_bits=NULL;
+    edge_hash=NULL;
+
+    edge_row_words=(n>>5)+1;
+    long matrix_words=(long)n*edge_row_words;
+    if (n<=1024 || matrix_words<=8*edges)
+      { edge_bits=new unsigned int[matrix_words];
+        ptrcheck(edge_bits);
+        memset(edge_bits, 0, matrix_words*sizeof(unsigned int));
+        for(i=0; i<n; i++)
+          for(j=0; j<out_count[i]; j++)
+            edge_bits[i*edge_row_words+(out[i][j]>>5)] |= 1u<<(out[i][j]&31);
+        return;
+      }
+
+    int bits=1;
+    while ((1L<<bits) < 2*edges)
+      bits++;
+    unsigned int size=1u<<bits, mask=size-1;
+    edge_hash_shift=32-bits;
+    edge_hash=new unsigned int[size];
+    ptrcheck(edge_hash);
+    memset(edge_hash, 0xFF, size*sizeof(unsigned int));
+    for(i=0; i<n; i++)
+      for(j=0; j<out_count[i]; j++)
+        { unsigned int key=((unsigned int)i<<16)|out[i][j];
+          unsigned int h=(key*2654435761u)>>edge_hash_shift;
+          while (edge_hash[h]!=0xFFFFFFFFu && edge_hash[h]!=key)
+            h=(h+1)&mask;
+          edge_hash[h]=key;
+        }
+  }
+
 /*-------------------------------------------------------------------
  * Change the attribute of an edge. It is an error if the edge
  * does not exist.
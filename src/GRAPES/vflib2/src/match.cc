@@ -166,14 +166,21 @@ int matchFrom(State *s0, match_visitor vis, void *usr_data, node_id qnode, node_
     if (!c1 || !c2)
       error("Out of memory");
 
-    int count=0;
-    State* s1 = s0->Clone();
-    s1->AddPair(qnode, tnode);
-    match(c1, c2, vis, usr_data, s1, &count);
-    delete s1;
+    int count=matchFrom(s0, vis, usr_data, qnode, tnode, c1, c2);
 
     delete[] c1;
     delete[] c2;
     return count;
   }
 
+
+int matchFrom(State *s0, match_visitor vis, void *usr_data, node_id qnode, node_id tnode,
+              node_id c1[], node_id c2[])
+  { int count=0;
+    State* s1 = s0->Clone();
+    s1->AddPair(qnode, tnode);
+    match(c1, c2, vis, usr_data, s1, &count);
+    s1->BackTrack();
+    delete s1;
+    return count;
+  }
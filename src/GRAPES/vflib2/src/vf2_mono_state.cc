@@ -31,6 +31,12 @@
  * This information is used for backtracking.
  * The fields t1out_len etc. also count the nodes in core.
  * The true t1out_len is t1out_len-core_len!
+ * The undo log records, for each level, the node of g1 added 
+ * at that level and the lengths before the addition, so that
+ * a single state can be extended and backtracked in place 
+ * (AddPair/UndoPair) without cloning it at each level.
+ * A state whose pairs have all been undone has clean vectors,
+ * and can be reused for another target graph (Reset).
  ---------------------------------------------------------*/
 
 
@@ -69,15 +75,17 @@ VF2MonoState::VF2MonoState(Graph *ag1, Graph *ag2, bool sortNodes)
 
 	added_node1=NULL_NODE;
 
+    max_n2=n2;
     core_1=new node_id[n1];
     core_2=new node_id[n2];
     in_1=new node_id[n1];
     in_2=new node_id[n2];
     out_1=new node_id[n1];
     out_2=new node_id[n2];
+    undo_log=new UndoEntry[n1+1];
 	share_count = new long;
     if (!core_1 || !core_2 || !in_1 || !in_2 
-	    || !out_1 || !out_2 || !share_count)
+	    || !out_1 || !out_2 || !undo_log || !share_count)
       error("Out of memory");
 
     int i;
@@ -126,6 +134,8 @@ VF2MonoState::VF2MonoState(const VF2MonoState &state)
     in_2=state.in_2;
     out_1=state.out_1;
     out_2=state.out_2;
+    undo_log=state.undo_log;
+    max_n2=state.max_n2;
     share_count=state.share_count;
 
 	++ *share_count;
@@ -145,6 +155,7 @@ VF2MonoState::~VF2MonoState()
       delete [] out_1;
       delete [] in_2;
       delete [] out_2;
+      delete [] undo_log;
       delete share_count;
       delete [] order;
 	}
@@ -273,7 +284,8 @@ bool VF2MonoState::IsFeasiblePair(node_id node1, node_id node2)
         if (core_1[other1] != NULL_NODE)
           { other2=core_1[other1];
             if (!g2->HasEdge(node2, other2) ||
-                !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(node2, other2)))
+                (g1->HasEdgeComparator() &&
+                 !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(node2, other2))))
               return false;
           }
         else 
@@ -292,7 +304,8 @@ bool VF2MonoState::IsFeasiblePair(node_id node1, node_id node2)
         if (core_1[other1]!=NULL_NODE)
           { other2=core_1[other1];
             if (!g2->HasEdge(other2, node2) ||
-                !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(other2, node2)))
+                (g1->HasEdgeComparator() &&
+                 !g1->CompatibleEdge(attr1, g2->GetEdgeAttr(other2, node2))))
               return false;
           }
         else 
@@ -355,6 +368,15 @@ void VF2MonoState::AddPair(node_id node1, node_id node2)
     assert(core_len<n1);
     assert(core_len<n2);
 
+    UndoEntry &entry=undo_log[core_len];
+    entry.node1=node1;
+    entry.t1both_len=t1both_len;
+    entry.t2both_len=t2both_len;
+    entry.t1in_len=t1in_len;
+    entry.t1out_len=t1out_len;
+    entry.t2in_len=t2in_len;
+    entry.t2out_len=t2out_len;
+
     core_len++;
 	added_node1=node1;
 
@@ -510,3 +532,107 @@ void VF2MonoState::BackTrack()
 	  }
 
   }
+
+
+
+/*----------------------------------------------------------------
+ * void VF2MonoState::UndoPair()
+ * Undoes the last AddPair performed on this state, restoring
+ * the vectors and the lengths of the terminal sets from the
+ * undo log. Unlike BackTrack, it can be applied repeatedly.
+ ----------------------------------------------------------------*/
+void VF2MonoState::UndoPair()
+  { assert(core_len > 0);
+
+    UndoEntry &entry=undo_log[core_len-1];
+    node_id node1=entry.node1;
+    node_id node2=core_1[node1];
+    int i, other;
+
+    if (in_1[node1] == core_len)
+      in_1[node1] = 0;
+    for(i=0; i<g1->InEdgeCount(node1); i++)
+      { other=g1->GetInEdge(node1, i);
+        if (in_1[other]==core_len)
+          in_1[other]=0;
+      }
+
+    if (out_1[node1] == core_len)
+      out_1[node1] = 0;
+    for(i=0; i<g1->OutEdgeCount(node1); i++)
+      { other=g1->GetOutEdge(node1, i);
+        if (out_1[other]==core_len)
+          out_1[other]=0;
+      }
+
+    if (in_2[node2] == core_len)
+      in_2[node2] = 0;
+    for(i=0; i<g2->InEdgeCount(node2); i++)
+      { other=g2->GetInEdge(node2, i);
+        if (in_2[other]==core_len)
+          in_2[other]=0;
+      }
+
+    if (out_2[node2] == core_len)
+      out_2[node2] = 0;
+    for(i=0; i<g2->OutEdgeCount(node2); i++)
+      { other=g2->GetOutEdge(node2, i);
+        if (out_2[other]==core_len)
+          out_2[other]=0;
+      }
+
+    core_1[node1] = NULL_NODE;
+    core_2[node2] = NULL_NODE;
+
+    t1both_len=entry.t1both_len;
+    t2both_len=entry.t2both_len;
+    t1in_len=entry.t1in_len;
+    t1out_len=entry.t1out_len;
+    t2in_len=entry.t2in_len;
+    t2out_len=entry.t2out_len;
+
+    core_len--;
+    orig_core_len=core_len;
+    added_node1=NULL_NODE;
+  }
+
+
+/*----------------------------------------------------------------
+ * void VF2MonoState::Reset(ag2)
+ * Makes this state an empty state between g1 and ag2.
+ * The state must own its vectors and be empty, i.e. every
+ * pair must have been undone: its vectors are then clean, and
+ * they are only reallocated if ag2 has more nodes than the
+ * previous targets.
+ ----------------------------------------------------------------*/
+void VF2MonoState::Reset(Graph *ag2)
+  { assert(core_len == 0);
+    assert(*share_count == 1);
+
+    g2=ag2;
+    n2=g2->NodeCount();
+
+    if (n2 > max_n2)
+      { delete [] core_2;
+        delete [] in_2;
+        delete [] out_2;
+        core_2=new node_id[n2];
+        in_2=new node_id[n2];
+        out_2=new node_id[n2];
+        if (!core_2 || !in_2 || !out_2)
+          error("Out of memory");
+
+        int i;
+        for(i=0; i<n2; i++)
+          { core_2[i]=NULL_NODE;
+            in_2[i]=0;
+            out_2[i]=0;
+          }
+        max_n2=n2;
+      }
+
+    core_len=orig_core_len=0;
+    t1both_len=t1in_len=t1out_len=0;
+    t2both_len=t2in_len=t2out_len=0;
+    added_node1=NULL_NODE;
+  }
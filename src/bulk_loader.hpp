@@ -0,0 +1,293 @@
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef BULK_LOADER_HPP
+#define BULK_LOADER_HPP
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <meddly.h>
+#include <meddly_expert.h>
+
+#include "buffer.hpp"
+
+
+namespace mtmdd {
+    class BulkLoader;
+
+    /** BulkLoader builds a fully reduced mtmdd bottom-up from its minterms, without applying PLUS.
+     * Minterms are gathered in runs; each run is sorted in the level order of the forest, from the top level down,
+     * and spilled to a temporary file. The runs are then merged, summing the values of equal minterms, and
+     * every node is created through the unique table once all its children are known.
+     * Besides the diagram, memory holds one run while minterms are added and, while merging,
+     * a read buffer for each run and the children of one open node per level. */
+    class BulkLoader {
+        //a sorted run on disk, read a block of records at a time
+        class RunReader {
+            std::FILE* file;
+            const size_t key_size;
+            std::vector<int> keys;
+            std::vector<long> values;
+            size_t pos = 0, count = 0;
+
+        public:
+            RunReader(std::FILE* file, size_t key_size, size_t block_size)
+            : file(file), key_size(key_size), keys(key_size * block_size), values(block_size) {
+                std::rewind(file);
+            }
+
+            ~RunReader() {
+                std::fclose(file);
+            }
+
+            //it moves to the next record, false at the end of the run
+            bool next() {
+                if (++pos < count)
+                    return true;
+                for (count = 0, pos = 0; count < values.size(); ++count) {
+                    if (std::fread(&keys[count * key_size], sizeof(int), key_size, file) != key_size
+                            || std::fread(&values[count], sizeof(long), 1, file) != 1)
+                        break;
+                }
+                return count > 0;
+            }
+
+            inline const int* key() const { return &keys[pos * key_size]; }
+            inline long value() const { return values[pos]; }
+        };
+
+        MEDDLY::expert_forest* forest;
+        //number of levels, i.e. of variables, in a minterm
+        const int num_levels;
+        //variable at each depth, depth 0 being the top level
+        std::vector<int> var_at_depth;
+
+        //minterms of the run being gathered, in level order, and their values
+        const size_t run_size;
+        std::vector<int> run_keys;
+        std::vector<long> run_values;
+        //sorted runs spilled to disk
+        std::vector<std::FILE*> runs;
+
+        //children of the open node at each depth, by increasing index
+        std::vector<std::vector<std::pair<int, MEDDLY::node_handle>>> open_nodes;
+        //last minterm added to the open nodes
+        std::vector<int> last_key;
+
+    public:
+        //records read at once from each run
+        size_t block_size = 4096;
+        //runs merged at once; more runs are merged in several passes
+        size_t max_fanin = 128;
+
+        BulkLoader(MEDDLY::forest* f, size_t run_size)
+        : forest(static_cast<MEDDLY::expert_forest*>(f)), num_levels(f->getDomain()->getNumVariables()), 
+          var_at_depth(num_levels), run_size(run_size), open_nodes(num_levels) {
+            if (!forest->isFullyReduced() || run_size == 0)
+                throw std::invalid_argument("bulk loading needs a fully reduced forest and runs of at least one minterm");
+            for (int depth = 0; depth < num_levels; ++depth)
+                var_at_depth[depth] = forest->getVarByLevel(num_levels - depth);
+            run_keys.reserve(run_size * num_levels);
+            run_values.reserve(run_size);
+        }
+
+        ~BulkLoader() {
+            for (std::FILE* run: runs)
+                std::fclose(run);
+        }
+
+        //it adds a minterm, indexed by variable as in forest::createEdge
+        void add(const int* minterm, long value) {
+            for (int depth = 0; depth < num_levels; ++depth)
+                run_keys.push_back(minterm[var_at_depth[depth]]);
+            run_values.push_back(value);
+
+            if (run_values.size() == run_size)
+                spill();
+        }
+
+        inline void add(Buffer& buffer) {
+            int** minterms = buffer.data();
+            const long* values = buffer.values_data();
+            for (unsigned i = 0; i < buffer.num_elements(); ++i)
+                add(minterms[i], values ? values[i] : 1);
+        }
+
+        //it merges the runs into @result, the diagram of the sum of all the minterms added
+        void build(MEDDLY::dd_edge& result) {
+            spill();
+            while (runs.size() > max_fanin) {
+                //merge the oldest runs into a new one
+                std::vector<std::FILE*> group(runs.begin(), runs.begin() + max_fanin);
+                std::FILE* merged = new_run();
+                runs.erase(runs.begin(), runs.begin() + max_fanin);
+                merge(group, [this, merged](const int* key, long value) { write(merged, key, value); });
+                runs.push_back(merged);
+            }
+
+            std::vector<std::FILE*> group;
+            group.swap(runs);
+            last_key.clear();
+            merge(group, [this](const int* key, long value) { push(key, value); });
+            if (last_key.empty()) {
+                result.set(0);
+            } else {
+                close_below(0);
+                result.set(close(0));
+            }
+        }
+
+    private:
+        std::FILE* new_run() {
+            std::FILE* run = std::tmpfile();
+            if (!run)
+                throw std::runtime_error("cannot create a temporary file for bulk loading");
+            return run;
+        }
+
+        inline void write(std::FILE* run, const int* key, long value) {
+            if (std::fwrite(key, sizeof(int), num_levels, run) != static_cast<size_t>(num_levels)
+                    || std::fwrite(&value, sizeof(long), 1, run) != 1)
+                throw std::runtime_error("cannot write a bulk loading run");
+        }
+
+        //it sorts the current run, sums equal minterms and writes it to a temporary file
+        void spill() {
+            if (run_values.empty())
+                return;
+
+            std::vector<size_t> order(run_values.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+                return std::lexicographical_compare(
+                    run_keys.begin() + a * num_levels, run_keys.begin() + (a + 1) * num_levels, 
+                    run_keys.begin() + b * num_levels, run_keys.begin() + (b + 1) * num_levels); 
+            });
+
+            std::FILE* run = new_run();
+            for (size_t i = 0; i < order.size(); ) {
+                const int* key = &run_keys[order[i] * num_levels];
+                long value = 0;
+                for (; i < order.size() && std::equal(key, key + num_levels, &run_keys[order[i] * num_levels]); ++i)
+                    value += run_values[order[i]];
+                write(run, key, value);
+            }
+            runs.push_back(run);
+
+            run_keys.clear();
+            run_values.clear();
+        }
+
+        /* k-way merge of sorted runs, closing them: each distinct minterm goes to @sink once, 
+         * in order, with the sum of its values */
+        template <typename Sink>
+        void merge(const std::vector<std::FILE*>& group, Sink sink) {
+            std::vector<RunReader*> readers;
+            auto greater = [&readers, this](size_t a, size_t b) {
+                return std::lexicographical_compare(
+                    readers[b]->key(), readers[b]->key() + num_levels, readers[a]->key(), readers[a]->key() + num_levels); 
+            };
+            std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+            std::vector<int> key;
+            long value = 0;
+
+            for (std::FILE* run: group)
+                readers.push_back(new RunReader(run, num_levels, block_size));
+            try {
+                for (size_t i = 0; i < readers.size(); ++i)
+                    if (readers[i]->next())
+                        heap.push(i);
+
+                while (!heap.empty()) {
+                    RunReader* top = readers[heap.top()];
+                    if (!key.empty() && std::equal(key.begin(), key.end(), top->key())) {
+                        value += top->value();
+                    } else {
+                        if (!key.empty())
+                            sink(key.data(), value);
+                        key.assign(top->key(), top->key() + num_levels);
+                        value = top->value();
+                    }
+
+                    size_t i = heap.top();
+                    heap.pop();
+                    if (readers[i]->next())
+                        heap.push(i);
+                }
+                if (!key.empty())
+                    sink(key.data(), value);
+            } catch (...) {
+                for (RunReader* reader: readers)
+                    delete reader;
+                throw;
+            }
+            for (RunReader* reader: readers)
+                delete reader;
+        }
+
+        /* it adds the next minterm, greater than the previous one: the open nodes below the first level 
+         * where they differ are complete, and they are reduced */
+        void push(const int* key, long value) {
+            //a null value is the transparent terminal, i.e. no minterm
+            if (value == 0)
+                return;
+
+            if (!last_key.empty()) {
+                int depth = 0;
+                while (key[depth] == last_key[depth])
+                    ++depth;
+                close_below(depth);
+            }
+            open_nodes[num_levels - 1].emplace_back(key[num_levels - 1], forest->handleForValue(value));
+            last_key.assign(key, key + num_levels);
+        }
+
+        //the nodes open below @depth become children of their parents, from the bottom level up
+        void close_below(int depth) {
+            for (int d = num_levels - 1; d > depth; --d)
+                open_nodes[d - 1].emplace_back(last_key[d - 1], close(d));
+        }
+
+        //it creates the reduced node open at @depth
+        MEDDLY::node_handle close(int depth) {
+            std::vector<std::pair<int, MEDDLY::node_handle>>& children = open_nodes[depth];
+            MEDDLY::unpacked_node* nb = MEDDLY::unpacked_node::newSparse(forest, num_levels - depth, children.size());
+            for (size_t i = 0; i < children.size(); ++i) {
+                nb->i_ref(i) = children[i].first;
+                nb->d_ref(i) = children[i].second;
+            }
+            children.clear();
+            return forest->createReducedNode(-1, nb);
+        }
+    };
+}
+
+#endif //BULK_LOADER_HPP
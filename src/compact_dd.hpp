@@ -0,0 +1,632 @@
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMPACT_DD_HPP
+#define COMPACT_DD_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <meddly.h>
+#include <meddly_expert.h>
+
+#include "mapped_file.hpp"
+
+
+namespace mtmdd {
+    class CompactDiagram;
+
+    /** CompactDiagram is a read-only copy of a fully reduced mtmdd, laid out for traversal.
+     * Nodes are numbered bottom-up, level by level, and stored one after the other in a byte array.
+     * Each record holds the level and the children of a node: either all of them, as fixed size references
+     * indexed directly, or only the non null ones, as varint pairs (index gap, reference) with a jump entry
+     * every few children; the smaller of the two is chosen for each node.
+     * A reference is a node id or a terminal value, told apart by its lowest bit; 0 is the null terminal.
+     * There are no reference counts nor hash tables: the copy is built once and never changes, so that
+     * several threads can read it at once.
+     * The copy can be written to a file and queried from there without loading it: records never cross a page,
+     * and the file is mapped so that the pages of the nodes visited are read on demand, within a memory cap. */
+    class CompactDiagram {
+    public:
+        using ref_t = uint32_t;
+
+    private:
+        //children between two jump entries of a sparse node
+        static const uint32_t jump_step = 32;
+        //records smaller than a page do not cross its boundaries, so that a node is read at once from disk
+        static const size_t page_size = 4096;
+        //first bytes of a diagram written to a file
+        static const uint64_t file_magic = 0x3230444344445247; //"GRDDCD02"
+
+        int num_levels;
+        //variable at each level, and its bound
+        std::vector<int> level_vars, level_bounds;
+        //node records, and where each one starts; node ids start from 1
+        std::vector<uint8_t> records;
+        std::vector<uint64_t> offsets;
+        size_t num_edges = 0;
+        //number of minterms with a non null value, counted once the diagram is built
+        long num_minterms = 0;
+        ref_t root;
+
+        //records and offsets, either in the vectors above or in a mapped file, at the given positions
+        const uint8_t* record_data;
+        const uint64_t* offset_data;
+        size_t node_count;
+        std::unique_ptr<MappedFile> file;
+        size_t records_pos = 0, offsets_pos = 0;
+
+        static inline bool is_node(ref_t r) {
+            return (r & 1) == 0 && r != 0;
+        }
+
+        static inline long value(ref_t r) {
+            return r >> 1;
+        }
+
+        static inline uint32_t read_varint(const uint8_t*& p) {
+            uint32_t v = 0;
+            for (int shift = 0; ; shift += 7) {
+                const uint8_t b = *p++;
+                v |= uint32_t(b & 0x7f) << shift;
+                if (b < 0x80)
+                    return v;
+            }
+        }
+
+        static inline void write_varint(std::vector<uint8_t>& out, uint32_t v) {
+            for (; v >= 0x80; v >>= 7)
+                out.push_back(uint8_t(v) | 0x80);
+            out.push_back(uint8_t(v));
+        }
+
+        static inline uint32_t load32(const uint8_t* p) {
+            uint32_t v;
+            std::memcpy(&v, p, sizeof(v));
+            return v;
+        }
+
+        static inline void store32(std::vector<uint8_t>& out, uint32_t v) {
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+            out.insert(out.end(), p, p + sizeof(v));
+        }
+
+        //node record, decoded up to its children
+        struct NodeView {
+            int level;
+            bool full;
+            //number of slots if full, of non null children otherwise
+            uint32_t size;
+            //slots, or the jump entries (index, entry offset) followed by the children
+            const uint8_t* jumps;
+            const uint8_t* children;
+
+            //an empty full node
+            NodeView() : level(0), full(true), size(0), jumps(nullptr), children(nullptr) {}
+
+            NodeView(const uint8_t* p) {
+                const uint32_t header = read_varint(p);
+                level = read_varint(p);
+                full = header & 1;
+                size = header >> 1;
+                jumps = p;
+                children = full ? p : p + 8 * ((size - 1) / jump_step);
+            }
+
+            //child at index @i, or the null terminal
+            ref_t child(int i) const {
+                if (full)
+                    return uint32_t(i) < size ? load32(children + 4 * size_t(i)) : 0;
+
+                //the last jump entry not past @i, if any, gives where to start reading
+                const uint32_t num_jumps = (size - 1) / jump_step;
+                uint32_t lo = 0, hi = num_jumps;
+                while (lo < hi) {
+                    const uint32_t mid = (lo + hi) / 2;
+                    if (load32(jumps + 8 * mid) <= uint32_t(i))
+                        lo = mid + 1;
+                    else
+                        hi = mid;
+                }
+                const uint8_t* p = children;
+                uint32_t index = 0, left = size;
+                if (lo > 0) {
+                    //the gap before the child of a jump entry is skipped, its index is known
+                    const uint8_t* jump = jumps + 8 * (lo - 1);
+                    index = load32(jump);
+                    p += load32(jump + 4);
+                    read_varint(p);
+                    const ref_t r = read_varint(p);
+                    if (index == uint32_t(i))
+                        return r;
+                    left -= lo * jump_step + 1;
+                }
+                while (left-- > 0) {
+                    index += read_varint(p);
+                    if (index > uint32_t(i))
+                        return 0;
+                    const ref_t r = read_varint(p);
+                    if (index == uint32_t(i))
+                        return r;
+                }
+                return 0;
+            }
+        };
+
+        inline NodeView node(ref_t r) const {
+            const size_t id = r >> 1;
+            if (file) {
+                file->touch(offsets_pos + id * sizeof(uint64_t));
+                file->touch(records_pos + offset_data[id]);
+            }
+            return NodeView(record_data + offset_data[id]);
+        }
+
+        inline int level(ref_t r) const {
+            return is_node(r) ? node(r).level : 0;
+        }
+
+    public:
+        //it copies the diagram of @edge, which is left unchanged
+        explicit CompactDiagram(const MEDDLY::dd_edge& edge) {
+            const MEDDLY::expert_forest* forest = static_cast<const MEDDLY::expert_forest*>(edge.getForest());
+            if (!forest->isFullyReduced() || !forest->isMultiTerminal())
+                throw std::invalid_argument("only fully reduced multi-terminal mtmdds can be compacted");
+
+            num_levels = forest->getDomain()->getNumVariables();
+            level_vars.assign(num_levels + 1, 0);
+            level_bounds.assign(num_levels + 1, 0);
+            for (int k = 1; k <= num_levels; ++k) {
+                level_vars[k] = forest->getVarByLevel(k);
+                level_bounds[k] = forest->getDomain()->getVariableBound(level_vars[k]);
+            }
+
+            //nodes by level, children before their parents
+            std::vector<std::vector<MEDDLY::node_handle>> nodes(num_levels + 1);
+            std::unordered_map<MEDDLY::node_handle, ref_t> refs;
+            collect(forest, edge.getNode(), nodes, refs);
+
+            ref_t next_id = 1;
+            for (int k = 1; k <= num_levels; ++k)
+                for (MEDDLY::node_handle h: nodes[k])
+                    refs[h] = next_id++ << 1;
+
+            offsets.reserve(next_id);
+            offsets.push_back(0);
+            std::vector<std::pair<uint32_t, ref_t>> children;
+            std::vector<uint8_t> sparse, record;
+            for (int k = 1; k <= num_levels; ++k) {
+                for (MEDDLY::node_handle h: nodes[k]) {
+                    MEDDLY::unpacked_node* nr = MEDDLY::unpacked_node::newFromNode(forest, h, MEDDLY::unpacked_node::SPARSE_NODE);
+                    children.clear();
+                    for (int z = 0; z < nr->getNNZs(); ++z)
+                        children.emplace_back(nr->i(z), to_ref(forest, nr->d(z), refs));
+                    MEDDLY::unpacked_node::recycle(nr);
+                    num_edges += children.size();
+                    append(k, children, sparse, record);
+                }
+            }
+            records.shrink_to_fit();
+            root = to_ref(forest, edge.getNode(), refs);
+            record_data = records.data();
+            offset_data = offsets.data();
+            node_count = offsets.size() - 1;
+            std::vector<long> node_cards(node_count + 1, -1);
+            num_minterms = cardinality(root, num_levels, node_cards);
+        }
+
+        /* it opens a copy written at @offset of @filename, reading its nodes from disk when they are visited:
+         * at most about @memory_cap bytes of the file are kept in memory, 0 for no limit */
+        CompactDiagram(const std::string& filename, size_t offset, size_t memory_cap)
+        : file(new MappedFile(filename, memory_cap)) {
+            const uint8_t* p = file->data() + offset;
+            uint64_t magic, header[6];
+            if (offset + sizeof(magic) + sizeof(header) > file->size())
+                throw std::runtime_error("No compact diagram in " + filename);
+            std::memcpy(&magic, p, sizeof(magic));
+            std::memcpy(header, p + sizeof(magic), sizeof(header));
+            if (magic != file_magic)
+                throw std::runtime_error("No compact diagram in " + filename);
+            num_levels = header[0];
+            root = header[1];
+            node_count = header[2];
+            num_edges = header[3];
+            const size_t records_size = header[4];
+            num_minterms = header[5];
+
+            p += sizeof(magic) + sizeof(header);
+            level_vars.resize(num_levels + 1);
+            level_bounds.resize(num_levels + 1);
+            std::memcpy(level_vars.data(), p, level_vars.size() * sizeof(int));
+            p += level_vars.size() * sizeof(int);
+            std::memcpy(level_bounds.data(), p, level_bounds.size() * sizeof(int));
+
+            offsets_pos = align(offset + sizeof(magic) + sizeof(header) + 2 * level_vars.size() * sizeof(int), sizeof(uint64_t));
+            records_pos = align(offsets_pos + (node_count + 1) * sizeof(uint64_t), page_size);
+            if (records_pos + records_size > file->size())
+                throw std::runtime_error("Truncated compact diagram in " + filename);
+            offset_data = reinterpret_cast<const uint64_t*>(file->data() + offsets_pos);
+            record_data = file->data() + records_pos;
+        }
+
+        /* it writes the diagram to @out, starting at the next page: it returns the position where it starts,
+         * to be given when the diagram is opened from the file */
+        size_t write(std::ostream& out) const {
+            const size_t offset = pad(out, page_size);
+            const uint64_t header[6] = {uint64_t(num_levels), root, node_count, num_edges,
+                                        uint64_t(node_count ? offset_data[node_count] + record_size(node_count) : 0), 
+                                        uint64_t(num_minterms)};
+            const uint64_t magic = file_magic;
+            out.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(level_vars.data()), level_vars.size() * sizeof(int));
+            out.write(reinterpret_cast<const char*>(level_bounds.data()), level_bounds.size() * sizeof(int));
+            pad(out, sizeof(uint64_t));
+            out.write(reinterpret_cast<const char*>(offset_data), (node_count + 1) * sizeof(uint64_t));
+            pad(out, page_size);
+            out.write(reinterpret_cast<const char*>(record_data), header[4]);
+            return offset;
+        }
+
+        //value of the minterm @vars, indexed by variable
+        long evaluate(const int* vars) const {
+            ref_t r = root;
+            while (is_node(r)) {
+                const NodeView nv(node(r));
+                r = nv.child(vars[level_vars[nv.level]]);
+            }
+            return value(r);
+        }
+
+        /* it multiplies this diagram by @query, a diagram of @result's forest over the same variables,
+         * building the product in that forest */
+        void multiply(const MEDDLY::dd_edge& query, MEDDLY::dd_edge& result) const {
+            MEDDLY::expert_forest* forest = static_cast<MEDDLY::expert_forest*>(result.getForest());
+            std::unordered_map<uint64_t, MEDDLY::node_handle> products;
+            MEDDLY::node_handle h = multiply(forest, root, query.getNode(), products);
+            //the products computed are kept until the end, with a reference of their own
+            for (const auto& product: products)
+                forest->unlinkNode(product.second);
+            result.set(h);
+        }
+
+        inline size_t num_nodes() const {
+            return node_count;
+        }
+
+        inline bool is_paged() const {
+            return file != nullptr;
+        }
+
+        //windows of the file read from disk and dropped to stay within the memory cap, if paged
+        inline size_t page_reads() const {
+            return file ? file->reads.load() : 0;
+        }
+
+        inline size_t page_drops() const {
+            return file ? file->drops.load() : 0;
+        }
+
+        inline size_t get_num_edges() const {
+            return num_edges;
+        }
+
+        //bytes taken by the diagram; if paged, the part of the file counted as resident
+        inline size_t memory_used() const {
+            return (file ? file->resident_bytes() : records.capacity() + offsets.capacity() * sizeof(uint64_t))
+                + (level_vars.capacity() + level_bounds.capacity()) * sizeof(int);
+        }
+
+        //number of minterms with a non null value; a paged diagram reads it from its header, without visiting the nodes
+        inline long cardinality() const {
+            return num_minterms;
+        }
+
+        //true if a diagram in the current format was written at @offset of @in
+        static bool written_at(std::istream& in, size_t offset) {
+            uint64_t magic = 0;
+            in.seekg(offset);
+            in.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+            return in && magic == file_magic;
+        }
+
+        /** enumerator visits the minterms with a non null value, in the order of the levels, as MEDDLY::enumerator does:
+         * the assignments are indexed by level, and a level skipped by a node takes all the values of its variable. */
+        class enumerator {
+            //position at a level: the edge entering it, and the child reached
+            struct Cursor {
+                ref_t edge, child;
+                bool skipped;
+                const uint8_t* pos;
+                uint32_t left;
+            };
+
+            const CompactDiagram& dd;
+            std::vector<Cursor> cursors;
+            std::vector<int> assignments;
+            bool valid;
+
+            void init(int k, ref_t edge) {
+                Cursor& c = cursors[k];
+                c.edge = edge;
+                c.skipped = dd.level(edge) < k;
+                if (!c.skipped) {
+                    const NodeView nv(dd.node(edge));
+                    c.pos = nv.children;
+                    c.left = nv.full ? 0 : nv.size;
+                }
+            }
+
+            //it moves the cursor of level @k to its first or next non null child
+            bool step(int k, bool first) {
+                Cursor& c = cursors[k];
+                int& index = assignments[k];
+                if (c.skipped) {
+                    index = first ? 0 : index + 1;
+                    c.child = c.edge;
+                    return index < dd.level_bounds[k];
+                }
+                const NodeView nv(dd.node(c.edge));
+                if (nv.full) {
+                    for (index = first ? 0 : index + 1; uint32_t(index) < nv.size; ++index)
+                        if ((c.child = load32(nv.children + 4 * size_t(index))) != 0)
+                            return true;
+                    return false;
+                }
+                if (c.left == 0)
+                    return false;
+                --c.left;
+                index = (first ? 0 : index) + read_varint(c.pos);
+                c.child = read_varint(c.pos);
+                return true;
+            }
+
+            //it moves level @k to its next child leading to a minterm, and the levels below to their first one
+            bool next(int k, bool first) {
+                while (step(k, first)) {
+                    first = false;
+                    if (k == 1)
+                        return true;
+                    init(k - 1, cursors[k].child);
+                    if (next(k - 1, true))
+                        return true;
+                }
+                return false;
+            }
+
+        public:
+            enumerator(const CompactDiagram& dd)
+            : dd(dd), cursors(dd.num_levels + 1), assignments(dd.num_levels + 1, 0) {
+                valid = dd.num_levels > 0 && dd.root != 0;
+                if (valid) {
+                    init(dd.num_levels, dd.root);
+                    valid = next(dd.num_levels, true);
+                }
+            }
+
+            inline operator bool() const {
+                return valid;
+            }
+
+            void operator++() {
+                for (int k = 1; k <= dd.num_levels; ++k)
+                    if (next(k, false))
+                        return;
+                valid = false;
+            }
+
+            inline const int* getAssignments() const {
+                return assignments.data();
+            }
+
+            inline void getValue(long& v) const {
+                v = value(cursors[1].child);
+            }
+
+            inline void getValue(int& v) const {
+                v = value(cursors[1].child);
+            }
+        };
+
+    private:
+        static void collect(const MEDDLY::expert_forest* forest, MEDDLY::node_handle h,
+                std::vector<std::vector<MEDDLY::node_handle>>& nodes, std::unordered_map<MEDDLY::node_handle, ref_t>& refs) {
+            if (forest->isTerminalNode(h) || !refs.emplace(h, 0).second)
+                return;
+            MEDDLY::unpacked_node* nr = MEDDLY::unpacked_node::newFromNode(forest, h, MEDDLY::unpacked_node::SPARSE_NODE);
+            for (int z = 0; z < nr->getNNZs(); ++z)
+                collect(forest, nr->d(z), nodes, refs);
+            MEDDLY::unpacked_node::recycle(nr);
+            nodes[forest->getNodeLevel(h)].push_back(h);
+        }
+
+        static ref_t to_ref(const MEDDLY::expert_forest* forest, MEDDLY::node_handle h,
+                const std::unordered_map<MEDDLY::node_handle, ref_t>& refs) {
+            if (!forest->isTerminalNode(h))
+                return refs.at(h);
+            const long v = forest->getIntegerFromHandle(h);
+            if (v < 0 || v > long(INT32_MAX))
+                throw std::invalid_argument("only non negative values can be compacted");
+            return v == 0 ? 0 : ref_t(v) << 1 | 1;
+        }
+
+        static inline size_t align(size_t n, size_t alignment) {
+            return (n + alignment - 1) / alignment * alignment;
+        }
+
+        //it pads @out with zeros up to a multiple of @alignment, returning the new position
+        static size_t pad(std::ostream& out, size_t alignment) {
+            const size_t pos = out.tellp();
+            for (size_t i = pos; i < align(pos, alignment); ++i)
+                out.put(0);
+            return align(pos, alignment);
+        }
+
+        //size of the record of the node @id
+        size_t record_size(size_t id) const {
+            const NodeView nv(record_data + offset_data[id]);
+            const uint8_t* p = nv.children;
+            if (nv.full)
+                return p + 4 * size_t(nv.size) - (record_data + offset_data[id]);
+            for (uint32_t z = 0; z < 2 * nv.size; ++z)
+                read_varint(p);
+            return p - (record_data + offset_data[id]);
+        }
+
+        //it writes the record of a node at level @k, full or sparse, whichever is smaller
+        void append(int k, const std::vector<std::pair<uint32_t, ref_t>>& children, std::vector<uint8_t>& sparse, std::vector<uint8_t>& record) {
+            const uint32_t nnz = children.size(),
+                           num_slots = children.back().first + 1;
+            sparse.clear();
+            std::vector<uint8_t> jumps;
+            uint32_t last = 0;
+            for (uint32_t z = 0; z < nnz; ++z) {
+                if (z > 0 && z % jump_step == 0) {
+                    store32(jumps, children[z].first);
+                    store32(jumps, sparse.size());
+                }
+                write_varint(sparse, children[z].first - last);
+                write_varint(sparse, children[z].second);
+                last = children[z].first;
+            }
+
+            const bool full = 4 * size_t(num_slots) <= sparse.size() + jumps.size();
+            record.clear();
+            write_varint(record, (full ? num_slots : nnz) << 1 | full);
+            write_varint(record, k);
+            if (full) {
+                std::vector<ref_t> slots(num_slots, 0);
+                for (const auto& child: children)
+                    slots[child.first] = child.second;
+                for (ref_t r: slots)
+                    store32(record, r);
+            }
+            else {
+                record.insert(record.end(), jumps.begin(), jumps.end());
+                record.insert(record.end(), sparse.begin(), sparse.end());
+            }
+
+            const size_t page_left = page_size - records.size() % page_size;
+            if (record.size() > page_left && record.size() <= page_size)
+                records.resize(records.size() + page_left, 0);
+            offsets.push_back(records.size());
+            records.insert(records.end(), record.begin(), record.end());
+        }
+
+        long cardinality(ref_t r, int k, std::vector<long>& node_cards) const {
+            if (r == 0)
+                return 0;
+            const int l = level(r);
+            long card = 1;
+            for (int j = l + 1; j <= k; ++j)
+                card *= level_bounds[j];
+            if (l == 0)
+                return card;
+
+            long& node_card = node_cards[r >> 1];
+            if (node_card < 0) {
+                node_card = 0;
+                for_each_child(r, [&](int, ref_t child) {
+                    node_card += cardinality(child, l - 1, node_cards);
+                });
+            }
+            return card * node_card;
+        }
+
+        //it calls @f on the index and the reference of each non null child of node @r
+        template <typename F>
+        void for_each_child(ref_t r, F f) const {
+            const NodeView nv(node(r));
+            if (nv.full) {
+                for (uint32_t i = 0; i < nv.size; ++i) {
+                    const ref_t child = load32(nv.children + 4 * size_t(i));
+                    if (child)
+                        f(i, child);
+                }
+                return;
+            }
+            const uint8_t* p = nv.children;
+            uint32_t index = 0;
+            for (uint32_t z = 0; z < nv.size; ++z) {
+                index += read_varint(p);
+                f(index, read_varint(p));
+            }
+        }
+
+        MEDDLY::node_handle multiply(MEDDLY::expert_forest* forest, ref_t a, MEDDLY::node_handle b,
+                std::unordered_map<uint64_t, MEDDLY::node_handle>& products) const {
+            if (a == 0 || b == 0)
+                return 0;
+            const int la = level(a), lb = forest->getNodeLevel(b);
+            if (la == 0 && lb == 0)
+                return forest->handleForValue(int(value(a) * forest->getIntegerFromHandle(b)));
+
+            const uint64_t key = uint64_t(a) << 32 | uint32_t(b);
+            auto it = products.find(key);
+            if (it != products.end())
+                return forest->linkNode(it->second);
+
+            //the children of the top one of the two nodes are multiplied by the other node, or by its children
+            const int k = std::max(la, lb);
+            std::vector<std::pair<int, MEDDLY::node_handle>> children;
+            if (lb == k) {
+                MEDDLY::unpacked_node* nb = MEDDLY::unpacked_node::newFromNode(forest, b, MEDDLY::unpacked_node::SPARSE_NODE);
+                const NodeView na = la == k ? node(a) : NodeView();
+                for (int z = 0; z < nb->getNNZs(); ++z) {
+                    const ref_t child = la == k ? na.child(nb->i(z)) : a;
+                    const MEDDLY::node_handle h = multiply(forest, child, nb->d(z), products);
+                    if (h != 0)
+                        children.emplace_back(nb->i(z), h);
+                }
+                MEDDLY::unpacked_node::recycle(nb);
+            }
+            else {
+                for_each_child(a, [&](int i, ref_t child) {
+                    const MEDDLY::node_handle h = multiply(forest, child, b, products);
+                    if (h != 0)
+                        children.emplace_back(i, h);
+                });
+            }
+
+            MEDDLY::unpacked_node* nr = MEDDLY::unpacked_node::newSparse(forest, k, children.size());
+            for (size_t z = 0; z < children.size(); ++z) {
+                nr->i_ref(z) = children[z].first;
+                nr->d_ref(z) = children[z].second;
+            }
+            const MEDDLY::node_handle h = forest->createReducedNode(-1, nr);
+            products.emplace(key, forest->linkNode(h));
+            return h;
+        }
+    };
+}
+
+#endif //COMPACT_DD_HPP
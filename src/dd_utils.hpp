@@ -27,9 +27,12 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define UTILS_HPP
 
 #include <iostream>
+#include <limits>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include <chrono>
 #include <exception>
 #include <map>
@@ -37,6 +40,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <string>
 #include <stdexcept>
 #include <sstream>
+#include <vector>
 
 
 #include <meddly.h>      
@@ -106,6 +110,8 @@ namespace mtmdd {
     struct StatsDD;
     class GraphNodeEncoder; 
     class Encoder;
+    class IndexStatistics;
+    class VertexSignatures;
 
 
     //it identifies one of the indexed graphs 
@@ -306,6 +312,12 @@ namespace mtmdd {
             return it != end() ? it->second : 0; 
         }
 
+        //it sets to @value the entries of @marks corresponding to the encoded nodes of the specified graph 
+        inline void mark_nodes(graph_id_t gid, std::vector<long>& marks, long value = 1) const {
+            for (auto it = lower_bound(graph_node_t(gid, 0)); it != end() && it->first.first == gid; ++it)
+                marks.at(it->second) = value; 
+        }
+
         //it returns the number of nodes of the specified graph  
         inline size_t num_nodes(graph_id_t gid) const {
             auto it = nodes_per_graph.find(gid); 
@@ -474,6 +486,187 @@ namespace mtmdd {
     }; 
 
 
+    /* searches and hits of the compute table caching the results of the mtmdd operations,
+     * in total and for each operation (by name, e.g. Plus or Multiply) */
+    struct ComputeTableStats {
+        long size = 0;          //number of slots of the table
+        long max_size = 0;      //limit to the number of slots
+        long entries = 0;       //number of cached results
+        long memory_used = 0;   //memory used by the slots and the entries
+        long pings = 0;         //number of searches
+        long hits = 0;          //number of searches finding a cached result
+        //searches and hits of each operation
+        std::map<std::string, std::pair<long, long>> op_searches;
+
+        //it reads the monolithic compute table, the one used by default; nothing is read without it
+        void read() {
+            MEDDLY::compute_table* ct = MEDDLY::operation::getMonolithicComputeTable();
+            *this = ComputeTableStats();
+            if (!ct)
+                return;
+
+            const MEDDLY::compute_table::stats& perf = ct->getStats();
+            size = ct->getTableSize();
+            max_size = ct->getMaxSize();
+            entries = perf.numEntries;
+            memory_used = ct->getMemUsed();
+            pings = perf.pings;
+            hits = perf.hits;
+
+            //slot 0 of the operation list is never used
+            for (unsigned i = 1; i < MEDDLY::operation::getOpListSize(); ++i) {
+                MEDDLY::operation* op = MEDDLY::operation::getOpWithIndex(i);
+                if (!op)
+                    continue;
+                std::pair<long, long>& searches = op_searches[op->getName()];
+                for (unsigned slot = 0; slot < op->getNumETids(); ++slot) {
+                    const MEDDLY::compute_table::entry_type* et = MEDDLY::compute_table::getEntryType(op, slot);
+                    searches.first += et->getPings();
+                    searches.second += et->getHits();
+                }
+            }
+        }
+
+        /* searches and hits counted after @before was read, with the current size of the table;
+         * operations destroyed in the meantime took their counts with them */
+        ComputeTableStats since(const ComputeTableStats& before) const {
+            ComputeTableStats delta(*this);
+            delta.pings -= before.pings;
+            delta.hits -= before.hits;
+            for (auto& op: delta.op_searches) {
+                auto it = before.op_searches.find(op.first);
+                if (it != before.op_searches.end() && it->second.first <= op.second.first) {
+                    op.second.first -= it->second.first;
+                    op.second.second -= it->second.second;
+                }
+            }
+            return delta;
+        }
+
+        inline double hit_rate() const {
+            return pings > 0 ? static_cast<double>(hits) / pings : 0;
+        }
+
+        inline double hit_rate(const std::string& op_name) const {
+            auto it = op_searches.find(op_name);
+            return it != op_searches.end() && it->second.first > 0 ? static_cast<double>(it->second.second) / it->second.first : 0;
+        }
+
+        //fraction of the slots holding an entry
+        inline double occupancy() const {
+            return size > 0 ? static_cast<double>(entries) / size : 0;
+        }
+
+        void show() const {
+            std::cout << "Compute table: " << size << " slots (max " << max_size << "), "
+                << entries << " entries, " << memory_used << " bytes, hit rate " << hit_rate();
+            for (const auto& op: op_searches)
+                if (op.second.first > 0)
+                    std::cout << ", " << op.first << " " << hit_rate(op.first);
+            std::cout << std::endl;
+        }
+    };
+
+
+    /** Adaptive limit to the slots of the monolithic compute table.
+     * MEDDLY grows the table up to its limit; once it is full, the limit is doubled as long as
+     * the previous growth raised the hit rate by min_gain and the doubled table fits the memory budget.
+     * Between queries the limit goes back to the initial one, and stale entries are dropped so that
+     * the table can shrink. With no memory budget the limit never changes. */
+    class ComputeTableSizer {
+        //limit to the slots before any growth
+        unsigned initial_size = 0;
+        //counters at the last check
+        ComputeTableStats last;
+        //hit rate before the last growth, negative if the table has not grown
+        double rate_before_growth = -1;
+        bool growing = true;
+
+    public:
+        //memory in bytes the table and its entries may use, 0 to keep the limit fixed
+        size_t memory_budget = 0;
+        //hit rate gain a growth has to bring to try another one
+        double min_gain = 0.01;
+
+        //to be called after the operations filling the table, e.g. after each insertion of paths
+        void check() {
+            MEDDLY::compute_table* ct = MEDDLY::operation::getMonolithicComputeTable();
+            if (!ct || memory_budget == 0)
+                return;
+            if (initial_size == 0)
+                initial_size = ct->getMaxSize();
+
+            ComputeTableStats current;
+            current.read();
+            const double rate = current.since(last).hit_rate();
+            last = current;
+
+            //the table is still growing by itself
+            if (current.size < current.max_size)
+                return;
+
+            if (rate_before_growth >= 0 && rate < rate_before_growth + min_gain)
+                growing = false;
+            if (growing && static_cast<size_t>(current.memory_used) * 2 <= memory_budget
+                    && ct->getMaxSize() <= std::numeric_limits<unsigned>::max() / 2) {
+                rate_before_growth = rate;
+                ct->setMaxSize(2 * ct->getMaxSize());
+            }
+        }
+
+        //to be called between queries: the table returns to its initial limit
+        void relax() {
+            MEDDLY::compute_table* ct = MEDDLY::operation::getMonolithicComputeTable();
+            if (!ct || initial_size == 0)
+                return;
+
+            MEDDLY::operation::removeStalesFromMonolithic();
+            ct->setMaxSize(initial_size);
+            rate_before_growth = -1;
+            growing = true;
+            last.read();
+        }
+    };
+
+
+    /** Garbage collection of a forest with optimistic deletion, deferred until memory runs short.
+     * The forest keeps the nodes left without incoming edges, and the compute table entries using them,
+     * so that the next operations can find them again. Once the memory of the nodes passes the threshold,
+     * the stale entries are swept until no such node is left, i.e. only the nodes reachable from the edges
+     * still alive remain, and the node storage is compacted. The threshold then becomes twice the memory left,
+     * if larger, so that a forest outgrowing it is not collected after every operation. */
+    class DeferredCollector {
+        size_t limit = 0;
+
+    public:
+        //memory in bytes of the nodes that triggers a collection, 0 to never trigger one
+        size_t memory_threshold = 0;
+        //collections run, and nodes they freed
+        long collections = 0;
+        long freed_nodes = 0;
+
+        //to be called after the operations leaving nodes behind, e.g. after each insertion of paths
+        void check(MEDDLY::expert_forest* forest) {
+            if (memory_threshold == 0 || forest->isPessimistic())
+                return;
+            if (forest->getCurrentMemoryUsed() >= std::max(limit, memory_threshold))
+                collect(forest);
+        }
+
+        void collect(MEDDLY::expert_forest* forest) {
+            const long nodes_before = forest->getCurrentNumNodes();
+            //freeing a node can leave its children without incoming edges, but still cached
+            for (long nodes = nodes_before + 1; forest->getCurrentNumNodes() < nodes; ) {
+                nodes = forest->getCurrentNumNodes();
+                forest->garbageCollect();
+            }
+            forest->compactMemory();
+            limit = 2 * forest->getCurrentMemoryUsed();
+            ++collections;
+            freed_nodes += nodes_before - forest->getCurrentNumNodes();
+        }
+    };
+
     struct StatsDD {
         long num_vars = 0; //number of mtdd levels
         long num_graphs = 0;  //number of indexed graphs
@@ -485,6 +678,11 @@ namespace mtmdd {
         long num_edges = 0;  //current number of edges 
         long num_unique_nodes = 0; //current number of unique nodes 
         long cardinality = 0; //number of stored elements 
+        long page_reads = 0; //windows of a paged index read from disk 
+        long page_drops = 0; //windows of a paged index dropped to stay within its memory cap 
+        long gc_runs = 0; //deferred garbage collections run while building 
+        long gc_freed_nodes = 0; //nodes freed by them 
+        ComputeTableStats ct; //compute table of the mtdd operations 
 
         void show() {
             std::cout << "##################\n"
@@ -495,7 +693,315 @@ namespace mtmdd {
                 << "num unique nodes = " << num_unique_nodes << "\n"
                 << "num_edges = " << num_edges << "\n"
                 << "memory_used = " << memory_used << "  , peak = " << peak_memory << "\n"
-                << "cardinality = " << cardinality << std::endl; 
+                << "cardinality = " << cardinality << "\n"
+                << "deferred gc runs = " << gc_runs << "  , freed nodes = " << gc_freed_nodes << std::endl;
+            ct.show(); 
+        }
+    };
+
+
+    /** IndexStatistics collects label and path frequencies of the indexed graphs while the mtmdd is built.
+     * They are stored in a side section of the index file and used to plan query filtering. */
+    class IndexStatistics {
+    public:
+        //labelled path without the empty labels padding shorter paths 
+        using path_key_t = std::vector<node_label_t>; 
+
+        struct PathFrequency {
+            long num_vertices = 0;      //number of vertices starting the path 
+            long num_graphs = 0;        //number of graphs containing the path 
+            long num_occurrences = 0;   //total number of occurrences of the path 
+        }; 
+
+        //maximum number of path frequencies stored in the index, the most frequent ones are kept 
+        size_t max_stored_paths = 1000; 
+
+    private:
+        //number of vertices having a given label (labels are mapped starting from 1)
+        std::vector<long> label_frequency;
+        //total number of indexed vertices
+        long num_vertices = 0;
+        //label histogram of each indexed graph 
+        std::map<graph_id_t, std::map<node_label_t, long>> graph_label_counts; 
+        //frequencies of the labelled paths; after reading an index only the most frequent ones are available 
+        std::map<path_key_t, PathFrequency> path_frequency; 
+        //number of starting vertices of the most frequent discarded path, if some path has been discarded
+        long min_path_vertices = 0; 
+
+        //indexed graphs, the position of a graph in this vector identifies it in the label table 
+        std::vector<graph_id_t> indexed_graphs; 
+        //for each label, the graphs (by position) having some vertex with that label and how many 
+        std::vector<std::vector<std::pair<unsigned, long>>> graphs_per_label; 
+
+        static inline path_key_t make_key(const std::vector<node_label_t>& path) {
+            auto first_label = std::find_if(path.begin(), path.end(), [](node_label_t l) { return l != 0; }); 
+            return path_key_t(first_label, path.end()); 
+        }
+
+    public:
+        inline bool empty() const {
+            return num_vertices == 0;
+        }
+
+        inline void add_vertex(graph_id_t graph_id, node_label_t label) {
+            if (label >= label_frequency.size())
+                label_frequency.resize(label + 1, 0);
+            ++label_frequency.at(label);
+            ++graph_label_counts[graph_id][label]; 
+            ++num_vertices;
+        }
+
+        //it accounts for a labelled path (possibly padded with empty labels) found in some indexed graphs
+        inline void add_path(const std::vector<node_label_t>& path, long n_vertices, long n_graphs, long n_occurrences) {
+            PathFrequency& freq = path_frequency[make_key(path)]; 
+            freq.num_vertices += n_vertices; 
+            freq.num_graphs += n_graphs; 
+            freq.num_occurrences += n_occurrences; 
+        }
+
+        //fraction of indexed vertices having the given label; the empty label 0 does not constraint anything
+        inline double label_selectivity(int label) const {
+            if (label == 0 || empty())
+                return 1.0;
+            return label < label_frequency.size()
+                ? static_cast<double>(label_frequency.at(label)) / num_vertices
+                : 0.0;
+        }
+
+        /* fraction of indexed vertices starting the given path. 
+         * Paths without a stored frequency are estimated by their labels, assuming independence */
+        inline double path_selectivity(const std::vector<node_label_t>& path) const {
+            if (empty()) 
+                return 1.0; 
+
+            auto it = path_frequency.find(make_key(path)); 
+            if (it != path_frequency.end()) 
+                return static_cast<double>(it->second.num_vertices) / num_vertices; 
+
+            double selectivity = 1.0; 
+            for (const node_label_t& label: path)
+                selectivity *= label_selectivity(label); 
+            //discarded paths are less frequent than the stored ones 
+            return std::min(selectivity, static_cast<double>(min_path_vertices) / num_vertices); 
+        }
+
+        //it builds the label table used to filter graphs from their label histograms 
+        void build_label_table() {
+            indexed_graphs.clear(); 
+            graphs_per_label.assign(label_frequency.size(), {}); 
+
+            for (const auto& graph: graph_label_counts) {
+                for (const auto& entry: graph.second) 
+                    graphs_per_label.at(entry.first).emplace_back(indexed_graphs.size(), entry.second); 
+                indexed_graphs.push_back(graph.first); 
+            }
+        }
+
+        /* it fills @graphs with the indexed graphs having, for each label of @query_labels, 
+         * at least as many vertices as the query has */
+        void filter_graphs(const std::map<node_label_t, long>& query_labels, std::vector<graph_id_t>& graphs) const {
+            std::vector<unsigned> satisfied_labels(indexed_graphs.size(), 0); 
+            unsigned num_query_labels = 0; 
+
+            for (const auto& query_label: query_labels) {
+                if (query_label.first >= graphs_per_label.size())
+                    return; 
+                
+                for (const auto& entry: graphs_per_label.at(query_label.first)) 
+                    satisfied_labels[entry.first] += entry.second >= query_label.second; 
+                ++num_query_labels; 
+            }
+
+            for (unsigned i = 0; i < satisfied_labels.size(); ++i) 
+                if (satisfied_labels[i] == num_query_labels) 
+                    graphs.push_back(indexed_graphs[i]); 
+        }
+
+        //number of vertices of the given graph having the given label 
+        inline long graph_label_count(graph_id_t graph_id, node_label_t label) const {
+            auto git = graph_label_counts.find(graph_id); 
+            if (git == graph_label_counts.end()) 
+                return 0; 
+            auto lit = git->second.find(label); 
+            return lit != git->second.end() ? lit->second : 0; 
+        }
+
+        inline const std::map<graph_id_t, std::map<node_label_t, long>>& graph_labels() const {
+            return graph_label_counts; 
+        }
+
+        friend std::ostream& operator << (std::ostream& out, const IndexStatistics& stats) {
+            out << "stats\n"
+                << "labels " << stats.label_frequency.size() << "\n";
+            for (const long& freq: stats.label_frequency)
+                out << freq << " ";
+
+            out << "\ngraphs " << stats.graph_label_counts.size() << "\n"; 
+            for (const auto& graph: stats.graph_label_counts) {
+                out << graph.first << " " << graph.second.size(); 
+                for (const auto& entry: graph.second) 
+                    out << " " << entry.first << " " << entry.second; 
+                out << "\n"; 
+            }
+
+            //only the most frequent paths are stored 
+            std::vector<const std::pair<const path_key_t, PathFrequency>*> paths; 
+            for (const auto& entry: stats.path_frequency) 
+                paths.push_back(&entry); 
+            const size_t num_paths = std::min(paths.size(), stats.max_stored_paths); 
+            //one more path is ordered, the most frequent discarded one bounds the others 
+            std::partial_sort(paths.begin(), paths.begin() + std::min(paths.size(), num_paths + 1), paths.end(), 
+                [](const std::pair<const path_key_t, PathFrequency>* a, const std::pair<const path_key_t, PathFrequency>* b) {
+                    return a->second.num_vertices > b->second.num_vertices; 
+                }); 
+            
+            out << "paths " << num_paths << " " 
+                << (num_paths < paths.size() ? paths.at(num_paths)->second.num_vertices : 0) << "\n"; 
+            for (size_t i = 0; i < num_paths; ++i) {
+                const auto& entry = *paths.at(i); 
+                out << entry.first.size(); 
+                for (const node_label_t& label: entry.first) 
+                    out << " " << label; 
+                out << " " << entry.second.num_vertices 
+                    << " " << entry.second.num_graphs 
+                    << " " << entry.second.num_occurrences << "\n"; 
+            }
+            return out; 
+        }
+
+        //it reads the statistics section, if any; indexes built by older versions do not have it
+        bool read(std::istream& in) {
+            std::string keyword;
+            size_t nlabels, ngraphs, npaths;
+
+            if (!(in >> keyword) || keyword != "stats")
+                return false;
+            if (!(in >> keyword >> nlabels) || keyword != "labels")
+                return false;
+
+            label_frequency.assign(nlabels, 0);
+            num_vertices = 0;
+
+            for (long& freq: label_frequency) {
+                in >> freq;
+                num_vertices += freq;
+            }
+
+            //graph and path frequencies are optional 
+            if (!(in >> keyword >> ngraphs) || keyword != "graphs") 
+                return !in.bad(); 
+            
+            for (size_t i = 0; i < ngraphs; ++i) {
+                graph_id_t graph_id; 
+                size_t nentries; 
+                in >> graph_id >> nentries; 
+
+                std::map<node_label_t, long>& label_counts = graph_label_counts[graph_id]; 
+                for (size_t j = 0; j < nentries; ++j) {
+                    node_label_t label; 
+                    in >> label >> label_counts[label]; 
+                }
+            }
+            build_label_table(); 
+
+            if (!(in >> keyword >> npaths >> min_path_vertices) || keyword != "paths") 
+                return false; 
+            
+            for (size_t i = 0; i < npaths; ++i) {
+                size_t length; 
+                in >> length; 
+
+                path_key_t path(length); 
+                for (node_label_t& label: path)
+                    in >> label; 
+                PathFrequency& freq = path_frequency[path]; 
+                in >> freq.num_vertices >> freq.num_graphs >> freq.num_occurrences; 
+            }
+            return in.good() || in.eof();
+        }
+    };
+
+
+    /** VertexSignature summarizes the neighbourhood of a vertex: 
+     * a vertex can be matched to a query node only if its signature covers the query node one. */
+    struct VertexSignature {
+        unsigned in_degree = 0; 
+        unsigned out_degree = 0; 
+        //bit (l % 64) is set if some in or out neighbour has label l 
+        uint64_t neighbour_labels = 0; 
+
+        inline bool covers(const VertexSignature& query_sig) const {
+            return in_degree >= query_sig.in_degree 
+                && out_degree >= query_sig.out_degree 
+                && (query_sig.neighbour_labels & ~neighbour_labels) == 0; 
+        }
+
+        //it computes the signatures of all the nodes of a graph, indexed by node id 
+        static void compute(const GRAPESLib::Graph& g, std::vector<VertexSignature>& signatures) {
+            signatures.assign(g.nodes_count, VertexSignature()); 
+
+            for (node_id_t i = 0; i < g.nodes_count; ++i) {
+                const GRAPESLib::GNode& node = g.nodes[i]; 
+                signatures[i].out_degree = node.out_neighbors.size(); 
+
+                for (const node_id_t& neighbour: node.out_neighbors) {
+                    ++signatures[neighbour].in_degree; 
+                    signatures[i].neighbour_labels |= uint64_t(1) << (g.nodes[neighbour].label % 64); 
+                    signatures[neighbour].neighbour_labels |= uint64_t(1) << (node.label % 64); 
+                }
+            }
+        }
+    }; 
+
+
+    /** VertexSignatures stores the signatures of the indexed vertices in a flat array 
+     * indexed by their GraphNodeEncoder value. It is saved after the statistics section of the index. */
+    class VertexSignatures : public std::vector<VertexSignature> {
+        using base = std::vector<VertexSignature>; 
+    public:
+        //it stores the signatures of the nodes of graph @g, given the encoding of its nodes 
+        void add_graph(const GRAPESLib::Graph& g, const GraphNodeEncoder& gn_enc) {
+            std::vector<VertexSignature> graph_signatures; 
+            VertexSignature::compute(g, graph_signatures); 
+
+            for (node_id_t i = 0; i < g.nodes_count; ++i) {
+                const unsigned encoded_id = gn_enc.get(g.id, i); 
+                if (encoded_id >= size()) 
+                    resize(encoded_id + 1); 
+                at(encoded_id) = graph_signatures.at(i); 
+            }
+        }
+
+        //true if the encoded vertex can be matched to a query node having signature @query_sig 
+        inline bool feasible(unsigned encoded_id, const VertexSignature& query_sig) const {
+            return encoded_id >= size() || at(encoded_id).covers(query_sig); 
+        }
+
+        friend std::ostream& operator << (std::ostream& out, const VertexSignatures& signatures) {
+            out << "signatures " << signatures.size() << "\n"; 
+            for (const VertexSignature& sig: signatures) 
+                out << sig.in_degree << " " << sig.out_degree << " " << sig.neighbour_labels << "\n"; 
+            return out; 
+        }
+
+        //it reads the signatures section, if any 
+        bool read(std::istream& in) {
+            std::string keyword; 
+            size_t nvertices; 
+
+            clear(); 
+            if (!(in >> keyword >> nvertices) || keyword != "signatures") 
+                return false; 
+
+            resize(nvertices); 
+            for (VertexSignature& sig: *this) 
+                in >> sig.in_degree >> sig.out_degree >> sig.neighbour_labels; 
+            
+            if (in.fail()) {
+                clear(); 
+                return false; 
+            }
+            return true; 
         }
     }; 
 }
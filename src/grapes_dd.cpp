@@ -26,6 +26,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <memory>
 #include <meddly.h>
 #include <meddly_expert.h>
 
@@ -40,10 +41,17 @@ void create_logfile_indexing(const std::string& logname);
 void create_logfile_matching(const std::string& logname); 
 
 void add_to_indexing_logfile(const std::string& logname, const std::string& db_filename, 
-    const std::vector<long>& stats, const std::vector<double>& cpu_times);
+    const std::vector<long>& stats, const std::vector<double>& cpu_times, const ComputeTableStats& ct_stats);
 
 void add_to_matching_logfile(const std::string& logname, const std::string& db_filename, 
-    const std::string& query_filename, const std::vector<long>& stats, const std::vector<double>& cpu_times);
+    const std::string& query_filename, const std::vector<long>& stats, const std::vector<double>& cpu_times, 
+    const ComputeTableStats& ct_stats);
+
+void add_ct_columns(std::ostream& f, const ComputeTableStats& ct_stats); 
+
+void run_query(mtmdd::MultiterminalDecisionDiagram& mtmdd_index, mtmdd::QueryCache* query_cache, 
+    const std::string& graph_file, const std::string& query_file, const std::string& log_file, 
+    bool direct_graph, bool pipelined, MATCH_ENGINE engine, bool break_symmetries, long max_matches, long graph_max_matches, double budget, int nthreads, double load_time); 
 
 inline std::string basename(std::string filename) { 
     return filename.substr(filename.rfind("/") + 1);
@@ -64,12 +72,35 @@ int main(int argc, char** argv) {
         ("d, direct", "are graph direct?", cxxopts::value<std::string>()->default_value("true")) 
         ("t, nthreads", "number of threads to use", cxxopts::value<int>()->default_value("8")) 
         ("b, bsize", "size buffer to load data into mtmdd", cxxopts::value<int>()->default_value("10000"))
+        ("bulk", "build the index bottom-up from sorted runs of k paths spilled to disk, instead of summing batches of paths into it; 0 to disable", cxxopts::value<long>()->default_value("0"))
+        ("gc-threshold", "build keeping the unused nodes, with their cached results, until the mtmdd takes this many MB, then collect them at once; 0 to free them as soon as they are unused", cxxopts::value<int>()->default_value("0"))
+        ("apply-threads", "number of threads summing the paths into the mtmdd and intersecting it with the query", cxxopts::value<int>()->default_value("1"))
+        ("unique-table", "unique table of the mtmdd nodes (chained or open, for open addressing)", cxxopts::value<std::string>()->default_value("chained"))
+        ("compact", "query a read-only compact copy of the index, moved out of the mtmdd forest once loaded", cxxopts::value<std::string>()->default_value("true"))
+        ("paged", "query the index from a paged copy on disk, written next to the index when missing or older, keeping about this many MB of its nodes in memory (0 for no limit); -1 to load the whole index", cxxopts::value<int>()->default_value("-1"))
+        ("node-budget", "memory budget in MB of the mtmdd nodes, kept in one mmap arena: past it the build or query stops with an error; 0 for no limit", cxxopts::value<int>()->default_value("0"))
+        ("huge-pages", "back the arena of the mtmdd nodes with transparent huge pages, with a node budget", cxxopts::value<std::string>()->default_value("false"))
+        ("ct-size", "max number of slots of the compute table caching the results of the mtmdd operations", cxxopts::value<int>()->default_value("16777216"))
+        ("ct-budget", "memory budget in MB for the compute table to grow past ct-size while its hit rate improves, 0 to keep its size fixed", cxxopts::value<int>()->default_value("0"))
+        ("s, select", "filter using only a selective subset of the query paths", cxxopts::value<std::string>()->default_value("true"))
+        ("p, pipeline", "overlap candidate reduction and matching", cxxopts::value<std::string>()->default_value("true"))
+        ("e, engine", "subgraph matching algorithm used to verify the candidates (vf2 or ri)", cxxopts::value<std::string>()->default_value("vf2"))
+        ("symmetry", "count the matches of symmetric queries from one embedding per automorphism class", cxxopts::value<std::string>()->default_value("true"))
+        ("exists", "only find the matching graphs: stop matching each graph at its first match", cxxopts::value<std::string>()->default_value("false"))
+        ("k, max-matches", "stop matching after k matches, 0 to find all of them", cxxopts::value<long>()->default_value("0"))
+        ("graph-max-matches", "stop matching a graph after k matches, 0 to find all of them", cxxopts::value<long>()->default_value("0"))
+        ("budget", "time budget in seconds of each query, 0 for no limit: slower queries report partial results", cxxopts::value<double>()->default_value("0"))
+        ("batch", "file listing the query graphs to search, one per line (- to read them from stdin)", cxxopts::value<std::string>())
+        ("cache", "memory budget in KB for the results of repeated queries in batch mode", cxxopts::value<int>()->default_value("4096"))
         ("log", "log filename", cxxopts::value<std::string>()->default_value("indexing_results"));
 
     cxxopts::ParseResult result = options.parse(argc, argv); 
-    std::string graph_file, query_file, output_folder, log_file; 
-    int max_depth, nthreads, buffersize;
-    bool direct_graph; 
+    std::string graph_file, query_file, batch_file, output_folder, log_file; 
+    int max_depth, nthreads, apply_threads, buffersize, cache_size, ct_size, ct_budget, paged_cap, gc_threshold, node_budget;
+    bool direct_graph, select_paths, pipelined, break_symmetries, open_unique_table, compact_index, huge_pages; 
+    long max_matches, graph_max_matches, bulk_run_size; 
+    double budget; 
+    MATCH_ENGINE engine; 
 
 
     try {
@@ -78,12 +109,35 @@ int main(int argc, char** argv) {
         max_depth = result["lp"].as<int>();
         buffersize = result["bsize"].as<int>();
         nthreads = result["nthreads"].as<int>();
+        apply_threads = result["apply-threads"].as<int>();
+        gc_threshold = result["gc-threshold"].as<int>(); 
+        node_budget = result["node-budget"].as<int>(); 
+        huge_pages = result["huge-pages"].as<std::string>().compare("true") == 0; 
+        bulk_run_size = result["bulk"].as<long>(); 
+        open_unique_table = result["unique-table"].as<std::string>().compare("open") == 0; 
+        ct_size = result["ct-size"].as<int>(); 
+        ct_budget = result["ct-budget"].as<int>(); 
+        compact_index = result["compact"].as<std::string>().compare("true") == 0; 
+        paged_cap = result["paged"].as<int>(); 
         direct_graph = result["direct"].as<std::string>().compare("true") == 0; 
+        select_paths = result["select"].as<std::string>().compare("true") == 0; 
+        pipelined = result["pipeline"].as<std::string>().compare("true") == 0; 
+        break_symmetries = result["symmetry"].as<std::string>().compare("true") == 0; 
+        max_matches = result["max-matches"].as<long>(); 
+        graph_max_matches = result["graph-max-matches"].as<long>(); 
+        budget = result["budget"].as<double>(); 
+        if (result["exists"].as<std::string>().compare("true") == 0) 
+            graph_max_matches = 1; 
+        engine = result["engine"].as<std::string>().compare("ri") == 0 ? MATCH_ENGINE_RI : MATCH_ENGINE_VF2; 
+        cache_size = result["cache"].as<int>();
         log_file.assign(result["log"].as<std::string>());
 
-        if (result["query"].count() > 0) {
+        if (result["query"].count() > 0) 
             query_file.assign(result["query"].as<std::string>()); 
+        if (result["batch"].count() > 0) 
+            batch_file.assign(result["batch"].as<std::string>()); 
 
+        if (!query_file.empty() || !batch_file.empty()) {
             if (!grapes2dd::dd_already_indexed(graph_file, max_depth)) {
                 std::cerr << "You have to index the graph db before to perform query matching!" << std::endl; 
                 return 1; 
@@ -95,8 +149,11 @@ int main(int argc, char** argv) {
         std::cout << options.help() << std::endl; 
         return 1; 
     }
+
+    if (MEDDLY::compute_table* ct = MEDDLY::operation::getMonolithicComputeTable()) 
+        ct->setMaxSize(ct_size); 
     
-    if (query_file.empty()) {
+    if (query_file.empty() && batch_file.empty()) {
         // INDEX BUILDING 
         time_point start_build, end_build;
         time_point start_saving, end_saving; 
@@ -108,12 +165,26 @@ int main(int argc, char** argv) {
             << "Input database file: " << graph_file << "\n\n";
 
         start_build = std::chrono::_V2::steady_clock::now(); 
-        mtmdd::MultiterminalDecisionDiagram mtmdd_index(graph_file, max_depth, direct_graph, buffersize); 
+        mtmdd::MultiterminalDecisionDiagram mtmdd_index; 
+        mtmdd_index.set_apply_threads(apply_threads); 
+        mtmdd_index.set_open_unique_table(open_unique_table); 
+        mtmdd_index.set_ct_budget(static_cast<size_t>(ct_budget) << 20); 
+        mtmdd_index.bulk_run_size = bulk_run_size; 
+        mtmdd_index.set_deferred_gc(static_cast<size_t>(gc_threshold) << 20); 
+        mtmdd_index.set_node_budget(static_cast<size_t>(node_budget) << 20, huge_pages); 
+        try {
+            mtmdd_index.init(GraphsDB(graph_file, direct_graph), max_depth); 
+        } catch (MEDDLY::error& e) {
+            std::cerr << "Cannot build the index: " << e.getName() << " (node budget " << node_budget << " MB)" << std::endl; 
+            return 1; 
+        }
         end_build = std::chrono::_V2::steady_clock::now(); 
         time_build = get_time_interval(end_build, start_build); 
 
         start_saving = std::chrono::_V2::steady_clock::now(); 
         mtmdd_index.write(graph_file); 
+        if (paged_cap >= 0) 
+            mtmdd_index.write_paged(graph_file); 
         end_saving = std::chrono::_V2::steady_clock::now(); 
         time_saving = get_time_interval(end_saving, start_saving); 
 
@@ -133,7 +204,7 @@ int main(int argc, char** argv) {
         }; 
 
         log_file = dirname(graph_file) + "/" + log_file; 
-        add_to_indexing_logfile(log_file, basename(graph_file), current_stats, cpu_times); 
+        add_to_indexing_logfile(log_file, basename(graph_file), current_stats, cpu_times, stats.ct); 
 
         std::cout
             << "Number of graphs inside the database: " << mtmdd_index.num_indexed_graphs() << "\n\n"
@@ -141,85 +212,229 @@ int main(int argc, char** argv) {
             << "Memory required: " << stats.memory_used << " (peak = " << stats.peak_memory << ")\n"
             << "Num nodes in MTMDD: " << stats.num_nodes << " (peak = " << stats.peak_nodes << ")\n"
             << "Num edges: " << stats.num_edges << "\n"
+            << "Deferred garbage collections: " << stats.gc_runs << " (nodes freed: " << stats.gc_freed_nodes << ")\n"
             << "Time for build database index: " << time_build << "\n"
             << "Time for save index on file: " << time_saving << "\n"
             << "Total time: " << time_build + time_saving  << std::endl; 
+        stats.ct.show(); 
     } 
     else {
         // QUERY MATCHING 
-        mtmdd::MultiterminalDecisionDiagram mtmdd_index; 
+        const std::string index_file(grapes2dd::get_dd_index_name(graph_file, max_depth)); 
+        std::unique_ptr<mtmdd::MultiterminalDecisionDiagram> mtmdd_index; 
+        std::unique_ptr<mtmdd::QueryCache> query_cache; 
+        std::ifstream batch_stream; 
+        std::istream* batch_in = nullptr; 
         time_point start_loading, end_loading; 
-        std::vector<double> stages_times;  
-        double total_time = 0; 
+        double load_time = 0; 
+
+        //repeated queries are cached only in batch mode 
+        if (!batch_file.empty()) {
+            if (batch_file != "-") {
+                batch_stream.open(batch_file); 
+                batch_in = &batch_stream; 
+            } else {
+                batch_in = &std::cin; 
+            }
 
-        std::cout << "\t\t============== GRAPES-DD QUERY MATCHING ================\n\n"
-            << "Input database: " << graph_file << "\n"
-            << "Input query graph: " << query_file << "\n"
-            << "Number of threads: " << nthreads << "\n"
-            << "MAX LP depth: " << max_depth << std::endl;
+            if (cache_size > 0) 
+                query_cache.reset(new mtmdd::QueryCache(static_cast<size_t>(cache_size) * 1024)); 
+        }
 
-        start_loading = std::chrono::_V2::steady_clock::now(); 
-        mtmdd_index.read(graph_file, max_depth); 
-        end_loading = std::chrono::_V2::steady_clock::now(); 
-        stages_times.push_back(get_time_interval(end_loading, start_loading)); 
+        log_file = dirname(graph_file) + "/" + log_file; 
 
-        std::vector<GraphMatch> matched_graphs(mtmdd_index.match(query_file, nthreads, stages_times)); 
-        std::map<std::string, double> matching_stats;
+        try {
+            while (!query_file.empty() || (batch_in && std::getline(*batch_in, query_file))) {
+                if (query_file.empty()) 
+                    continue; 
+
+                //(re)load the index if it has changed, invalidating the cached results 
+                bool index_changed = query_cache && query_cache->validate(index_file); 
+
+                if (!mtmdd_index || index_changed) {
+                    mtmdd_index.reset(new mtmdd::MultiterminalDecisionDiagram()); 
+                    mtmdd_index->query_path_selection = select_paths; 
+                    mtmdd_index->set_apply_threads(apply_threads); 
+                    mtmdd_index->set_open_unique_table(open_unique_table); 
+                    mtmdd_index->set_ct_budget(static_cast<size_t>(ct_budget) << 20); 
+                    mtmdd_index->set_node_budget(static_cast<size_t>(node_budget) << 20, huge_pages); 
+
+                    start_loading = std::chrono::_V2::steady_clock::now(); 
+                    if (paged_cap < 0 || !mtmdd_index->read_paged(graph_file, max_depth, static_cast<size_t>(paged_cap) << 20)) {
+                        mtmdd_index->read(graph_file, max_depth); 
+                        if (paged_cap >= 0) 
+                            mtmdd_index->write_paged(graph_file); 
+                        if (compact_index) 
+                            mtmdd_index->compact(); 
+                    }
+                    end_loading = std::chrono::_V2::steady_clock::now(); 
+                    load_time = get_time_interval(end_loading, start_loading); 
+                }
+
+                std::cout << "\t\t============== GRAPES-DD QUERY MATCHING ================\n\n"
+                    << "Input database: " << graph_file << "\n"
+                    << "Input query graph: " << query_file << "\n"
+                    << "Number of threads: " << nthreads << "\n"
+                    << "MAX LP depth: " << max_depth << std::endl;
+
+                run_query(*mtmdd_index, query_cache.get(), graph_file, query_file, log_file, direct_graph, pipelined, engine, break_symmetries, max_matches, graph_max_matches, budget, nthreads, load_time); 
+                //the index is loaded once for all the queries 
+                load_time = 0; 
+                mtmdd_index->relax_compute_table(); 
+                query_file.clear(); 
+            }
+        } catch (MEDDLY::error& e) {
+            std::cerr << "Cannot query the index: " << e.getName() << " (node budget " << node_budget << " MB)" << std::endl; 
+            return 1; 
+        }
+
+        if (query_cache) 
+            std::cout << "Query cache hits: " << query_cache->hits << ", misses: " << query_cache->misses << std::endl; 
+    }
+
+    return 0; 
+}
+
+
+
+void run_query(
+    mtmdd::MultiterminalDecisionDiagram& mtmdd_index, 
+    mtmdd::QueryCache* query_cache, 
+    const std::string& graph_file, 
+    const std::string& query_file, 
+    const std::string& log_file, 
+    bool direct_graph, 
+    bool pipelined, 
+    MATCH_ENGINE engine, 
+    bool break_symmetries, 
+    long max_matches, 
+    long graph_max_matches, 
+    double budget, 
+    int nthreads, 
+    double load_time) {
+
+    std::vector<double> stages_times {load_time};  
+    std::map<std::string, double> matching_stats;
+    size_t num_matched_graphs = 0; 
+    double total_time = 0; 
+    bool cached_result = false; 
+    //the budget covers filtering and verification, from now on 
+    GRAPESLib::Deadline deadline(budget); 
+    //compute table searches of this query only 
+    ComputeTableStats ct_before; 
+    ct_before.read(); 
+
+    //the query is read and its paths extracted once, for the cache lookup and the matching 
+    time_point start_indexing = std::chrono::_V2::steady_clock::now(); 
+    std::unique_ptr<mtmdd::IndexedQuery> query(mtmdd_index.index_query(query_file, nthreads)); 
+    QueryForm form; 
+    const QueryCache::Entry* entry = nullptr; 
+
+    if (query_cache) {
+        mtmdd_index.get_query_form(*query, form); 
+        entry = query_cache->lookup(form); 
+    }
+    stages_times.push_back(get_time_interval(std::chrono::_V2::steady_clock::now(), start_indexing)); 
+
+    if (entry) {
+        //verification times are not spent again 
+        matching_stats = entry->match_stats; 
+        for (const std::string time_stat: {"load_db_time", "decompose_time", "matching_time", "tot_matching_time"})
+            matching_stats[time_stat] = 0; 
+        num_matched_graphs = entry->candidate_graphs.size(); 
+        cached_result = true; 
+        stages_times.push_back(0); 
+        stages_times.push_back(0); 
+    } else {
+        std::vector<GraphMatch> matched_graphs(mtmdd_index.match(*query, nthreads, stages_times, &deadline, &matching_stats)); 
+
+        //the path extraction and the lookup are accounted as query indexing time 
+        stages_times.at(1) += stages_times.at(2); 
+        stages_times.erase(stages_times.begin() + 2); 
 
         mtmdd::graph_find(graph_file,
             query_file, 
             direct_graph, 
             nthreads, 
+            pipelined, 
+            engine, 
+            break_symmetries, 
+            max_matches, 
+            graph_max_matches, 
+            &deadline, 
             mtmdd_index.labelMapping,
             matched_graphs, 
             matching_stats
         );
+        num_matched_graphs = matched_graphs.size(); 
+
+        //partial results of a timed out query are not reused 
+        if (query_cache && matching_stats["complete"]) {
+            std::vector<unsigned> candidate_graphs; 
+            for (const GraphMatch& gm: matched_graphs) 
+                candidate_graphs.push_back(gm.graph_id); 
+            query_cache->insert(form, candidate_graphs, matching_stats); 
+        }
+    }
 
-        for (auto it = stages_times.begin(); it != stages_times.end(); ++it)
-            total_time += *it; 
-
-        total_time += matching_stats["tot_matching_time"]; 
-        
-        stages_times.push_back(total_time); 
+    for (auto it = stages_times.begin(); it != stages_times.end(); ++it)
+        total_time += *it; 
 
+    total_time += matching_stats["tot_matching_time"]; 
+    
+    stages_times.push_back(total_time); 
+
+    std::cout 
+        << "Number of graphs inside the database: " << mtmdd_index.num_indexed_graphs() << "\n"
+        << "Number of candidate graphs: " << matching_stats["n_cand_graphs"] << "\n"
+        << "Number of connected components by filtering: "<< matching_stats["n_cocos"] << "\n"
+        << "Number of matching graphs: "<< matching_stats["n_matching_g"] <<"\n"
+        << "Number of found matches: "<< matching_stats["n_found_m"] <<"\n"; 
+    if (matching_stats["n_automorphisms"] > 1) 
+        std::cout << "Number of query automorphisms: " << matching_stats["n_automorphisms"] << "\n"; 
+    if (matching_stats["n_skipped_tasks"] > 0) 
+        std::cout << "Number of skipped tasks: " << matching_stats["n_skipped_tasks"] << "\n"; 
+    if (!matching_stats["complete"]) 
         std::cout 
-            << "Number of graphs inside the database: " << mtmdd_index.num_indexed_graphs() << "\n"
-            << "Number of candidate graphs: " << matching_stats["n_cand_graphs"] << "\n"
-            << "Number of connected components by filtering: "<< matching_stats["n_cocos"] << "\n"
-            << "Number of matching graphs: "<< matching_stats["n_matching_g"] <<"\n"
-            << "Number of found matches: "<< matching_stats["n_found_m"] <<"\n"
-            << "Time to load the index: " << stages_times.at(0) << "\n"
-            << "Time to query indexing: " << stages_times.at(1) << "\n"
-            << "Time to extract candidate paths: " << stages_times.at(2) << "\n"
-            << "Filtering time: " << stages_times.at(3) << "\n"
-            << "DB load time: " << matching_stats["load_db_time"] << "\n"
-            << "DB's decomposing time: " << matching_stats["decompose_time"] << "\n"
-            << "Matching time: " << matching_stats["matching_time"] << "\n"
-            << "Total time: " << total_time  << "\n"; 
-
-        StatsDD stats; 
-        mtmdd_index.get_stats(stats); 
-
-        std::vector<long> current_stats {
-            stats.num_vars, stats.num_graphs, stats.num_labels, static_cast<long>(direct_graph), 
-            static_cast<long>(matched_graphs.size())
-        }; 
-        
-        log_file = dirname(graph_file) + "/" + log_file; 
-        add_to_matching_logfile(
-            log_file, 
-            basename(graph_file), 
-            basename(query_file),
-            current_stats, 
-            stages_times
-        ); 
-    }
-
-    return 0; 
+            << "Time budget exceeded: partial results\n"
+            << "Filtered index vertices: " << matching_stats["n_filtered_vertices"] << "\n"
+            << "Reduced candidate graphs: " << matching_stats["n_reduced_graphs"] << " of " << matching_stats["n_filtered_graphs"] << "\n"
+            << "Verified tasks: " << matching_stats["n_verified_tasks"] << " of " << matching_stats["n_tasks"] << "\n"; 
+    if (query_cache) 
+        std::cout << "Results from cache: " << (cached_result ? "yes" : "no") << "\n"; 
+    std::cout 
+        << "Time to load the index: " << stages_times.at(0) << "\n"
+        << "Time to query indexing: " << stages_times.at(1) << "\n"
+        << "Time to extract candidate paths: " << stages_times.at(2) << "\n"
+        << "Filtering time: " << stages_times.at(3) << "\n"
+        << "DB load time: " << matching_stats["load_db_time"] << "\n"
+        << "DB's decomposing time: " << matching_stats["decompose_time"] << "\n"
+        << "Matching time: " << matching_stats["matching_time"] << "\n"
+        << "Total time: " << total_time  << "\n"; 
+
+    StatsDD stats; 
+    mtmdd_index.get_stats(stats); 
+    const ComputeTableStats ct_stats(stats.ct.since(ct_before)); 
+    ct_stats.show(); 
+    if (stats.page_reads > 0) 
+        std::cout << "Index windows read from disk: " << stats.page_reads << " (dropped: " << stats.page_drops << ")\n"; 
+
+    std::vector<long> current_stats {
+        stats.num_vars, stats.num_graphs, stats.num_labels, static_cast<long>(direct_graph), 
+        static_cast<long>(num_matched_graphs)
+    }; 
+    
+    add_to_matching_logfile(
+        log_file, 
+        basename(graph_file), 
+        basename(query_file),
+        current_stats, 
+        stages_times, 
+        ct_stats
+    ); 
 }
 
 
-
 void create_logfile_indexing(const std::string& logname) {
     std::string filename(logname + ".dd_stats");
 
@@ -230,7 +445,8 @@ void create_logfile_indexing(const std::string& logname) {
             "db", "depth", "ngraphs", "nlabels", "direct",
             "nnodes", "pnodes", "nedges", 
             "mem", "peak_mem", "nelems", 
-            "build_t", "save_t", "total_t"
+            "build_t", "save_t", "total_t", 
+            "ct_size", "ct_occ", "ct_hit", "plus_hit", "mult_hit"
         }; 
 
         f << header.at(0); 
@@ -249,7 +465,8 @@ void create_logfile_matching(const std::string& logname) {
         std::vector<std::string> header{
             "db", "query", "depth", "ngraphs", "nlabels", "direct", 
             "nmatched_g",
-            "load_t", "q_index_t", "q_match_f", "q_filter_t", "total_t" 
+            "load_t", "q_index_t", "q_match_f", "q_filter_t", "total_t", 
+            "ct_size", "ct_occ", "ct_hit", "plus_hit", "mult_hit"
         }; 
 
         f << header.at(0); 
@@ -259,7 +476,8 @@ void create_logfile_matching(const std::string& logname) {
     }   
 }
 
-void add_to_indexing_logfile(const std::string& logname, const std::string& db_filename, const std::vector<long>& stats, const std::vector<double>& cpu_times) {
+void add_to_indexing_logfile(const std::string& logname, const std::string& db_filename, const std::vector<long>& stats, const std::vector<double>& cpu_times, 
+    const ComputeTableStats& ct_stats) {
     create_logfile_indexing(logname); 
     
     std::string filename(logname + ".dd_stats"); 
@@ -268,6 +486,7 @@ void add_to_indexing_logfile(const std::string& logname, const std::string& db_f
     f << db_filename; 
     for (const long& stat: stats)       f << "\t" << stat; 
     for (const double& stat: cpu_times) f << "\t" << stat; 
+    add_ct_columns(f, ct_stats); 
     f << std::endl; 
 }
 
@@ -276,7 +495,8 @@ void add_to_matching_logfile(
     const std::string& db_filename, 
     const std::string& query_filename,
     const std::vector<long>& stats, 
-    const std::vector<double>& cpu_times) {
+    const std::vector<double>& cpu_times, 
+    const ComputeTableStats& ct_stats) {
 
     create_logfile_matching(logname); 
 
@@ -286,5 +506,11 @@ void add_to_matching_logfile(
     f << db_filename << "\t" << query_filename; 
     for (const long& stat: stats)       f << "\t" << stat;
     for (const double& stat: cpu_times) f << "\t" << stat;
+    add_ct_columns(f, ct_stats); 
     f << std::endl;
+}
+
+void add_ct_columns(std::ostream& f, const ComputeTableStats& ct_stats) {
+    f << "\t" << ct_stats.size << "\t" << ct_stats.occupancy() << "\t" << ct_stats.hit_rate() 
+      << "\t" << ct_stats.hit_rate("Plus") << "\t" << ct_stats.hit_rate("Multiply"); 
 }
\ No newline at end of file
@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace mtmdd {
+    class MappedFile;
+
+    /** MappedFile maps a file read-only: its pages are read from disk the first time they are accessed.
+     * The resident part of the file is kept within a memory cap by a CLOCK sweep over windows of the file.
+     * Readers report the windows they access through touch; once more windows are resident than the cap allows,
+     * the windows not touched since the last pass of the sweep are dropped, to be read again when accessed.
+     * Dropping a window never invalidates pointers into the mapping, so readers may run in several threads;
+     * the cap only counts the windows where an access was reported, and is not exact. */
+    class MappedFile {
+        static const uint8_t resident_bit = 1, referenced_bit = 2;
+
+        int fd = -1;
+        uint8_t* base = nullptr;
+        size_t length = 0;
+        //windows that can be resident at once, 0 for no limit
+        size_t max_windows;
+        std::unique_ptr<std::atomic<uint8_t>[]> windows;
+        size_t num_windows, hand = 0;
+        std::atomic<size_t> resident;
+        std::mutex sweep_mutex;
+
+    public:
+        static constexpr size_t window_size = 1 << 16;
+
+        //windows read from disk, and dropped to stay within the cap
+        std::atomic<size_t> reads, drops;
+
+        //@memory_cap is in bytes, 0 for no limit
+        MappedFile(const std::string& filename, size_t memory_cap)
+        : max_windows(memory_cap ? std::max<size_t>(1, memory_cap / window_size) : 0), resident(0), reads(0), drops(0) {
+            struct stat info;
+            fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0)
+                throw std::runtime_error("Cannot open " + filename);
+            length = info.st_size;
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+                throw std::runtime_error("Cannot map " + filename);
+            base = static_cast<uint8_t*>(p);
+            num_windows = (length + window_size - 1) / window_size;
+            windows.reset(new std::atomic<uint8_t>[num_windows]);
+            for (size_t w = 0; w < num_windows; ++w)
+                windows[w].store(0, std::memory_order_relaxed);
+        }
+
+        ~MappedFile() {
+            if (base)
+                munmap(base, length);
+            if (fd >= 0)
+                close(fd);
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        inline const uint8_t* data() const {
+            return base;
+        }
+
+        inline size_t size() const {
+            return length;
+        }
+
+        //bytes of the file counted as resident
+        inline size_t resident_bytes() const {
+            return resident.load(std::memory_order_relaxed) * window_size;
+        }
+
+        //it reports an access to the byte at @offset
+        inline void touch(size_t offset) {
+            std::atomic<uint8_t>& window = windows[offset / window_size];
+            if (window.load(std::memory_order_relaxed) == (resident_bit | referenced_bit))
+                return;
+            if (window.fetch_or(resident_bit | referenced_bit) & resident_bit)
+                return;
+            ++reads;
+            if (++resident > max_windows && max_windows > 0)
+                sweep();
+        }
+
+    private:
+        //the hand clears the referenced windows it passes, and drops the first ones it finds unreferenced
+        void sweep() {
+            std::unique_lock<std::mutex> lock(sweep_mutex, std::try_to_lock);
+            if (!lock.owns_lock())
+                return;
+            for (size_t steps = 2 * num_windows; steps > 0 && resident > max_windows; --steps) {
+                std::atomic<uint8_t>& window = windows[hand];
+                const uint8_t state = window.load();
+                if (state & referenced_bit) {
+                    window.fetch_and(uint8_t(~referenced_bit));
+                } else if (state & resident_bit) {
+                    const size_t begin = hand * window_size;
+                    madvise(base + begin, std::min(window_size, length - begin), MADV_DONTNEED);
+                    window.store(0);
+                    --resident;
+                    ++drops;
+                }
+                hand = (hand + 1) % num_windows;
+            }
+        }
+    };
+}
+
+#endif //MAPPED_FILE_HPP
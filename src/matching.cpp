@@ -23,6 +23,9 @@ TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
 SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <thread>
+#include <atomic>
+
 #include "matching.hpp"
 
 #include "Options.h"
@@ -32,6 +35,8 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "AttributeComparator.h"
 #include "VF2GraphReaders.h"
+#include "GraphReaders.h"
+#include "QuerySymmetries.h"
 #include "argedit.h"
 
 
@@ -59,19 +64,155 @@ void mtmdd::QueryPattern::add_path_to_node(int current_node, const LabelledPath&
 }
 
 
-void mtmdd::MatchedQuery::match(MEDDLY::dd_edge& qmatches, std::vector<GraphMatch>& final_matches) {
-    MEDDLY::expert_forest* forest = static_cast<MEDDLY::expert_forest*>(query.query_dd->getForest());
-    MEDDLY::dd_edge& dd_query = *(query.query_dd); 
+void mtmdd::QueryPattern::get_label_counts(std::map<node_label_t, long>& label_counts) const {
+    //the label of a query node is the first label of the paths starting from it 
+    for (const auto& entry: paths_from_node) 
+        ++label_counts[entry.second.front()->back()]; 
+}
+
+
+void mtmdd::QueryPattern::select_all_paths() {
+    filtering_paths.clear(); 
+    filtering_paths_from_node.clear(); 
+
+    for (const LabelledPath& path: unique_paths)
+        filtering_paths.insert(&path); 
+    for (const auto& entry: paths_from_node) 
+        filtering_paths_from_node[entry.first] = entry.second.size(); 
+}
+
+
+void mtmdd::QueryPattern::select_filtering_paths(const IndexStatistics& stats) {
+    filtering_paths.clear(); 
+    filtering_paths_from_node.clear(); 
+
+    /* a path is redundant for the intersection if, from each of its starting nodes, the query has a longer path 
+     * beginning with it: every vertex having the longer path also has the shorter one. 
+     * Redundant paths are only verified on the candidate vertices, as they can still prune by occurrence number */
+    for (const auto& entry: nodes_from_path) {
+        const LabelledPath* path = entry.first; 
+        bool redundant_path = true; 
+
+        for (auto it = entry.second.begin(); redundant_path && it != entry.second.end(); ++it) {
+            const std::vector<const LabelledPath*>& node_paths = paths_from_node.at(*it); 
+            redundant_path = std::any_of(node_paths.begin(), node_paths.end(), 
+                [path](const LabelledPath* other) { return other->extends(*path); }); 
+        }
+
+        if (!redundant_path) {
+            filtering_paths.insert(path); 
+            for (const int& node: entry.second)
+                ++filtering_paths_from_node[node]; 
+        }
+    }
+
+    /* the selectivity of a path is the fraction of indexed vertices starting it. 
+     * Candidate vertices are verified against the most selective paths first, so that they are discarded early */ 
+    if (!stats.empty()) {
+        std::map<const LabelledPath*, double> selectivity; 
+
+        for (const LabelledPath& path: unique_paths) 
+            selectivity.emplace(&path, stats.path_selectivity(path)); 
+
+        for (auto& entry: paths_from_node) {
+            std::stable_sort(entry.second.begin(), entry.second.end(), 
+                [&selectivity](const LabelledPath* a, const LabelledPath* b) { 
+                    return selectivity.at(a) < selectivity.at(b); 
+                }); 
+        }
+    }
+}
+
+
+void mtmdd::MatchedQuery::match(MEDDLY::dd_edge& index, MEDDLY::dd_edge& qmatches, std::vector<GraphMatch>& final_matches, 
+        unsigned nthreads, GRAPESLib::Deadline* deadline) {
+    MEDDLY::expert_forest* forest = static_cast<MEDDLY::expert_forest*>(qmatches.getForest());
+    std::map<int, GraphMatch> matched_graphs; //maps from graph id to the list of its matchable vertices 
+
+    const int vertex_var = forest->getDomain()->getNumVariables(), 
+              bound = forest->getDomain()->getVariableBound(vertex_var); 
+
+    //a range of vertices is enumerated in one run only if the vertex variable is the top one 
+    if (nthreads <= 1 || forest->getLevelByVar(vertex_var) != vertex_var) {
+        filtered_vertices = match_slice(index, qmatches, 0, bound, matched_graphs, deadline); 
+    } else {
+        /* the vertex variable is split into ranges, each one giving a slice of the intersection; 
+         * the threads take the slices one at a time, to balance vertices having many paths */ 
+        const int num_slices = std::min<int>(bound, 4 * nthreads); 
+        std::vector<int> slices(num_slices + 1); 
+
+        for (int s = 0; s <= num_slices; ++s) 
+            slices[s] = long(bound) * s / num_slices; 
+
+        //each thread keeps its own matches and counter, merged once all of them are done 
+        std::vector<std::map<int, GraphMatch>> thread_graphs(nthreads); 
+        std::vector<size_t> thread_vertices(nthreads, 0); 
+        std::atomic<int> next_slice(0); 
+        std::vector<std::thread> threads; 
+
+        //no node is created or released until the forest is thawed 
+        forest->freeze(); 
+        for (unsigned t = 0; t < nthreads; ++t) 
+            threads.emplace_back([&, t]() {
+                for (int s = next_slice++; s < num_slices; s = next_slice++) 
+                    thread_vertices[t] += match_slice(index, qmatches, slices[s], slices[s + 1], thread_graphs[t], deadline); 
+            }); 
+        for (std::thread& thread: threads) 
+            thread.join(); 
+        forest->thaw(); 
+
+        for (unsigned t = 0; t < nthreads; ++t) {
+            filtered_vertices += thread_vertices[t]; 
+            for (const auto& entry: thread_graphs[t]) {
+                auto it = matched_graphs.emplace(entry.first, entry.second); 
+                if (!it.second) 
+                    it.first->second.merge(entry.second); 
+            }
+        }
+    }
+
+    for (auto x = matched_graphs.begin(); x != matched_graphs.end(); ++x)
+        if (x->second.is_complete_match()) {
+            final_matches.emplace_back(x->second); 
+        } 
+}
+
+
+size_t mtmdd::MatchedQuery::match_slice(MEDDLY::dd_edge& index, MEDDLY::dd_edge& qmatches, int first_vertex, int end_vertex, 
+        std::map<int, GraphMatch>& matched_graphs, GRAPESLib::Deadline* deadline) const {
+    MEDDLY::expert_forest* forest = static_cast<MEDDLY::expert_forest*>(qmatches.getForest());
     const var_order_t& var_order = var_ordering.var_order; 
     const int query_num_nodes = query.get_num_nodes(),
               node_index_default = forest->getDomain()->getNumVariables(),
               node_index_in_order = forest->getLevelByVar(node_index_default);
-    std::map<int, GraphMatch> matched_graphs; //maps from graph id to the list of its matchable vertices 
-    MEDDLY::enumerator e(qmatches); //iterator over matched query dd 
+    MEDDLY::enumerator e(MEDDLY::enumerator::VARS_FIXED, forest); //iterator over matched query dd 
+    size_t num_vertices = 0; 
+
+    //no variable is fixed: the enumeration starts from the first path of @first_vertex 
+    std::vector<int> minterm(node_index_default + 1, MEDDLY::DONT_CARE); 
+    e.startFixedVars(qmatches, minterm.data()); 
+    if (first_vertex > 0) {
+        std::fill(minterm.begin(), minterm.end(), 0); 
+        minterm[node_index_in_order] = first_vertex; 
+        e.seek(minterm.data()); 
+    }
+
+    //the query paths are evaluated on copies of their buffer entries, since the vertex is written in them 
+    std::map<const LabelledPath*, std::vector<int>> path_entries; 
+    for (const LabelledPath& path: query.unique_paths) {
+        const int* buffer_entry = path.get_pointer2buffer(); 
+        if (buffer_entry) 
+            path_entries.emplace(&path, std::vector<int>(buffer_entry, buffer_entry + node_index_default + 1)); 
+    }
 
     long vertex_n_occ; //variable that will be used as result in forest->evaluate
 
-    while (e) {
+    while (e && e.getAssignments()[node_index_in_order] < end_vertex) {
+        //the clock is read every 1024 vertices 
+        if (deadline && num_vertices % 1024 == 0 && deadline->passed())
+            break; 
+        ++num_vertices; 
+
         //obtain current node from pruned mtmdd 
         const int current_node_encoded_id = e.getAssignments()[node_index_in_order];   
         int current_graph, current_node;  
@@ -109,20 +250,34 @@ void mtmdd::MatchedQuery::match(MEDDLY::dd_edge& qmatches, std::vector<GraphMatc
             int current_query_node = support_entry.first; 
             const std::vector<const LabelledPath*>& paths_from_query_node(query.find_starting_paths(current_query_node)); 
 
-            if (support_entry.second >= paths_from_query_node.size()) {
+            //vertices having fewer neighbours or missing some neighbour label cannot match the query node 
+            if (!query.node_signatures.empty() && 
+                !signatures.feasible(current_node_encoded_id, query.node_signatures.at(current_query_node)))
+                continue; 
+
+            if (support_entry.second >= query.num_filtering_paths(current_query_node)) {
                 //for each path starting from the current query node, we have to check
                 //1. if the path also starts from the matched vertex
                 //2. if the occurrence number of the matched vertex is NOT LESS than the occurrence number of the query 
                 bool matched_node_flag = true; 
 
                 for (const LabelledPath* query_path: paths_from_query_node) {
-                    int* buffer_entry = query_path->get_pointer2buffer(); 
+                    int* buffer_entry = path_entries.at(query_path).data(); 
                     int query_n_occ = query_path->get_occurrence_number();
 
                     buffer_entry[node_index_default] = current_node_encoded_id;  
-                    forest->evaluate(qmatches, buffer_entry, vertex_n_occ); 
 
-                    if (vertex_n_occ / query_n_occ < query_n_occ) {
+                    if (query.is_filtering_path(query_path)) {
+                        //the intersection holds the product of vertex and query occurrences 
+                        forest->evaluate(qmatches, buffer_entry, vertex_n_occ); 
+                        vertex_n_occ /= query_n_occ; 
+                    } else if (compact_index) {
+                        vertex_n_occ = compact_index->evaluate(buffer_entry); 
+                    } else {
+                        forest->evaluate(index, buffer_entry, vertex_n_occ); 
+                    }
+
+                    if (vertex_n_occ < query_n_occ) {
                         matched_node_flag = false; 
                         break; 
                     }
@@ -135,10 +290,7 @@ void mtmdd::MatchedQuery::match(MEDDLY::dd_edge& qmatches, std::vector<GraphMatc
         }
     }
 
-    for (auto x = matched_graphs.begin(); x != matched_graphs.end(); ++x)
-        if (x->second.is_complete_match()) {
-            final_matches.emplace_back(x->second); 
-        } 
+    return num_vertices; 
 }
 
 
@@ -165,6 +317,12 @@ void mtmdd::graph_find(
         const std::string& query_graph_file,  
         bool direct_flag,
         int nthreads, 
+        bool pipelined, 
+        MATCH_ENGINE engine, 
+        bool break_symmetries, 
+        long max_matches, 
+        long graph_max_matches, 
+        GRAPESLib::Deadline* deadline, 
         const Encoder& labelMapping,
         const std::vector<GraphMatch>& matched_vertices, 
         std::map<std::string, double>& match_stats) {
@@ -233,17 +391,47 @@ void mtmdd::graph_find(
     GRAPESLib::QueryGraph aqg(squery);   
 	GRAPESLib::MatchingManager mman(aqg, rgraphs, fgset, gncands, *(new GRAPESLib::DefaultAttrComparator()), nthreads);
 	GRAPESLib::MatchRunner mrunner(mman, nthreads, squery->NodeCount(), mprint_opt);
-	mrunner.runInitPhase();
-	std::map<int, std::list<GRAPESLib::g_match_task_t> > assign;
-
-	mman.createBalancedRun(); 
+    mman.engine = engine; 
+    mman.match_limit = max_matches; 
+    mman.graph_match_limit = graph_max_matches; 
+    mman.deadline = deadline; 
+
+    //matches are only counted, so a single embedding is searched for each set of symmetric ones; 
+    //limits on the number of matches count embeddings, so they are all searched 
+    GRAPESLib::QuerySymmetries* symmetries = NULL; 
+    if (break_symmetries && mprint_opt == MPRINT_OPT_NO && max_matches == 0 && graph_max_matches == 0) {
+        //vflib's query keeps node ids only, labels are read from the query file 
+        GRAPESLib::Graph labelled_query(0); 
+        std::vector<node_label_t> query_labels; 
+        std::ifstream qis(query_graph_file.c_str(), std::ios::in); 
+        GRAPESLib::GraphReader_gff qreader(labelMap, qis); 
+        qreader.direct = direct_flag; 
+        qreader.readGraph(labelled_query); 
+        qis.close(); 
+
+        for (node_id_t i = 0; i < labelled_query.nodes_count; ++i) 
+            query_labels.push_back(labelled_query.nodes[i].label); 
+
+        symmetries = new GRAPESLib::QuerySymmetries(aqg, query_labels); 
+        if (!symmetries->isTrivial())
+            mman.symmetries = symmetries; 
+    }
 
+    if (pipelined) {
+        //candidate reduction is overlapped with matching, so its time is accounted as matching time 
+        decomposing_time = 0; 
+        match_t = std::chrono::_V2::steady_clock::now(); 
 
+        mrunner.runPipelined(rgraphs, *squery); 
+    } else {
+        mrunner.runInitPhase();
+        mman.createBalancedRun(); 
 
-    decomposing_time = get_time_interval(std::chrono::_V2::steady_clock::now(), balance_t); 
-    match_t = std::chrono::_V2::steady_clock::now(); 
+        decomposing_time = get_time_interval(std::chrono::_V2::steady_clock::now(), balance_t); 
+        match_t = std::chrono::_V2::steady_clock::now(); 
 
-    mrunner.runMatch(rgraphs, *squery);
+        mrunner.runMatch(rgraphs, *squery);
+    }
 
     matching_time = get_time_interval(std::chrono::_V2::steady_clock::now(), match_t); 
     total_time = matching_time + decomposing_time + load_db_time; 
@@ -254,9 +442,15 @@ void mtmdd::graph_find(
 
     int nof_cocos = 0;
     long nof_matches = 0;
+    long nof_skips = 0; 
+    long nof_tasks = mman.coco_units.size(); 
+    long nof_verified = 0; 
     for(thread_id_t i = 0; i  < nthreads; i++){
         nof_cocos += mman.number_of_cocos[i];
         nof_matches += mman.number_of_matches[i];
+        nof_skips += mman.number_of_skips[i]; 
+        nof_tasks += mman.number_of_splits[i]; 
+        nof_verified += mman.number_of_verified[i]; 
     }
 
     std::set<graph_id_t> matching_graphs;
@@ -271,4 +465,14 @@ void mtmdd::graph_find(
     match_stats.insert(std::pair<std::string, double>("n_cocos", nof_cocos)); 
     match_stats.insert(std::pair<std::string, double>("n_matching_g", matching_graphs.size())); 
     match_stats.insert(std::pair<std::string, double>("n_found_m", nof_matches));     
+    match_stats.insert(std::pair<std::string, double>("n_automorphisms", mman.symmetries ? mman.symmetries->automorphisms : 1)); 
+    match_stats.insert(std::pair<std::string, double>("n_skipped_tasks", nof_skips)); 
+    //progress of the verification phases, partial if the time budget has passed 
+    match_stats.insert(std::pair<std::string, double>("complete", deadline == nullptr || !deadline->hasExpired())); 
+    match_stats.insert(std::pair<std::string, double>("n_filtered_graphs", fgset.size())); 
+    match_stats.insert(std::pair<std::string, double>("n_reduced_graphs", mman.reduced_graphs)); 
+    match_stats.insert(std::pair<std::string, double>("n_tasks", nof_tasks)); 
+    match_stats.insert(std::pair<std::string, double>("n_verified_tasks", nof_verified)); 
+
+    delete symmetries; 
 }
\ No newline at end of file
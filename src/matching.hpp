@@ -27,6 +27,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define MATCHING_HPP 
 
 
+#include <algorithm>
 #include <vector>
 #include <set>
 #include <map>
@@ -34,9 +35,12 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <meddly.h>
 
 #include "buffer.hpp"
+#include "compact_dd.hpp"
 #include "dd_utils.hpp"
 
 #include "OCPTreeListeners.h"
+#include "Options.h"
+#include "Deadline.h"
 #include "typedefs.h"
 
 
@@ -96,6 +100,18 @@ namespace mtmdd {
             return  buffer_location; 
         }
 
+        //number of labels in the path, without the empty labels padding shorter paths 
+        inline size_t length() const {
+            return size() - std::count(begin(), end(), 0); 
+        }
+
+        /* true if this path starts with all the labels of @path and is longer than it; 
+         * labels are stored backward, from the last one to the starting one */ 
+        inline bool extends(const LabelledPath& path) const {
+            const size_t plength = path.length(); 
+            return length() > plength && std::equal(path.end() - plength, path.end(), end() - plength); 
+        }
+
         inline void print() const {
             for (auto it = begin(); it != end(); ++it)
                 std::cout << *it << " "; 
@@ -119,6 +135,12 @@ namespace mtmdd {
         Node2PathsMapping paths_from_node; 
         //mapping from paths to the list of query nodes from which that path starts
         Path2NodesMapping nodes_from_path; 
+        //paths intersected with the index; the remaining ones are only checked on the candidate vertices 
+        std::set<const LabelledPath*> filtering_paths; 
+        //number of filtering paths starting from each query node 
+        std::map<int, size_t> filtering_paths_from_node; 
+        //degrees and neighbourhood labels of the query nodes, indexed by node id 
+        std::vector<VertexSignature> node_signatures; 
 
         
         MEDDLY::dd_edge* query_dd = nullptr; 
@@ -146,6 +168,25 @@ namespace mtmdd {
             return paths_from_node.size(); 
         }
 
+        //it counts the query nodes having each label 
+        void get_label_counts(std::map<node_label_t, long>& label_counts) const; 
+
+        //use every path of the query to filter the index 
+        void select_all_paths(); 
+
+        /* choose the paths that are not implied by longer ones to filter the index, 
+         * and sort the paths of each node by their selectivity, estimated from index statistics */
+        void select_filtering_paths(const IndexStatistics& stats); 
+
+        inline bool is_filtering_path(const LabelledPath* path) const {
+            return filtering_paths.find(path) != filtering_paths.end(); 
+        }
+
+        inline size_t num_filtering_paths(const int qnode_id) const {
+            auto it = filtering_paths_from_node.find(qnode_id); 
+            return it != filtering_paths_from_node.end() ? it->second : 0; 
+        }
+
 
         void show() const {
             for (auto it = paths_from_node.begin(); it != paths_from_node.end(); ++it) {
@@ -170,11 +211,28 @@ namespace mtmdd {
         const QueryPattern& query; 
         const GraphNodeEncoder& gn_enc; 
         const VariableOrdering& var_ordering;
+        const VertexSignatures& signatures; 
     public:
-        MatchedQuery(const QueryPattern& query, const GraphNodeEncoder& gn_enc, const VariableOrdering& var_ordering) 
-            : var_ordering(var_ordering), query(query), gn_enc(gn_enc) {}
-
-        void match(MEDDLY::dd_edge& qmatches, std::vector<GraphMatch>& final_matches); 
+        //index vertices enumerated by match, to report the progress of a timed out query 
+        size_t filtered_vertices = 0; 
+        //compacted index, read in place of the index passed to match when set 
+        const CompactDiagram* compact_index = nullptr; 
+
+        MatchedQuery(const QueryPattern& query, const GraphNodeEncoder& gn_enc, const VariableOrdering& var_ordering, const VertexSignatures& signatures) 
+            : var_ordering(var_ordering), query(query), gn_enc(gn_enc), signatures(signatures) {}
+
+        /* @index is the whole mtmdd, @qmatches its intersection with the filtering paths of the query; 
+         * paths not used for filtering are checked directly on the index. 
+         * The vertices are split among @nthreads threads, reading the forest while it is frozen. 
+         * When @deadline passes, the graphs enumerated so far are returned */ 
+        void match(MEDDLY::dd_edge& index, MEDDLY::dd_edge& qmatches, std::vector<GraphMatch>& final_matches, 
+            unsigned nthreads = 1, GRAPESLib::Deadline* deadline = nullptr); 
+
+    private: 
+        /* it matches the vertices of @qmatches from @first_vertex to @end_vertex (excluded) into @matched_graphs, 
+         * seeking the first of them; it returns the number of vertices enumerated, and can run on several ranges at once */ 
+        size_t match_slice(MEDDLY::dd_edge& index, MEDDLY::dd_edge& qmatches, int first_vertex, int end_vertex, 
+            std::map<int, GraphMatch>& matched_graphs, GRAPESLib::Deadline* deadline) const; 
     }; 
 
     class GraphMatch : private std::vector< std::set<unsigned> > {
@@ -196,6 +254,12 @@ namespace mtmdd {
             at(query_node_id).insert(graph_node_id); 
         }
 
+        //it adds the matchable vertices of @gm, another match of the same graph 
+        inline void merge(const GraphMatch& gm) {
+            for (size_t i = 0; i < size(); ++i) 
+                at(i).insert(gm.at(i).begin(), gm.at(i).end()); 
+        }
+
         void get_node_cands(GRAPESLib::node_cands_t& ncands) const; 
 
         inline bool is_complete_match() const {
@@ -232,6 +296,12 @@ namespace mtmdd {
         const std::string& query_graph_file,  
         bool direct_flag,
         int nthreads, 
+        bool pipelined, 
+        MATCH_ENGINE engine, 
+        bool break_symmetries, 
+        long max_matches, 
+        long graph_max_matches, 
+        GRAPESLib::Deadline* deadline, 
         const Encoder& labelMapping,
         const std::vector<GraphMatch>& matched_vertices, 
         std::map<std::string, double>& match_stats); 
@@ -169,6 +169,16 @@ namespace MEDDLY {
   extern const memory_manager_style* MALLOC_MANAGER;
   extern const memory_manager_style* HEAP_MANAGER;
   extern const memory_manager_style* FREELISTS;   // used for compute tables
+  extern const memory_manager_style* ARENA_MANAGER;
+
+  /**
+    Memory budget of the nodes of each forest using ARENA_MANAGER,
+    read when the forest is created.
+    Its nodes live in an mmap arena of @bytes bytes (0 for the size of
+    the physical memory), backed by transparent huge pages if @huge_pages.
+    Past the budget, creating a node throws error::INSUFFICIENT_MEMORY.
+  */
+  void setArenaBudget(size_t bytes, bool huge_pages);
 
   // ******************************************************************
   // *                     Node storage mechanisms                    *
@@ -1101,6 +1111,15 @@ class MEDDLY::forest {
     	  LEVEL
       };
 
+      // Supported unique table implementations.
+      enum class unique_table_type {
+        // Hash buckets chained through the node headers, with move to front.
+        CHAINED,
+        // Open addressing with linear probing; each slot also keeps
+        // the hash of its node, compared before the node itself.
+        OPEN_ADDRESSING
+      };
+
       enum class reordering_type {
         // Always choose the lowest swappable inversion
         LOWEST_INVERSION,
@@ -1132,6 +1151,8 @@ class MEDDLY::forest {
       reordering_type reorder;
       // Default variable swap strategy.
       variable_swap_type swap;
+      // Unique table of each variable.
+      unique_table_type unique_table;
 
       /// Backend memory management mechanism for nodes.
       const memory_manager_style* nodemm;
@@ -1155,6 +1176,14 @@ class MEDDLY::forest {
       /// Should we run the memory compactor before trying to expand
       bool compactBeforeExpand;
 
+      /** Number of threads running PLUS and MULTIPLY on fully reduced MDDs;
+          1 for the sequential apply.
+          The threads only read the forests, which are frozen meanwhile.
+      */
+      int apply_threads;
+      /// Parallel apply: levels below the top one before splitting the work.
+      int apply_fork_depth;
+
       /// Empty constructor, for setting up defaults later
       policies();
 
@@ -1186,6 +1215,9 @@ class MEDDLY::forest {
 
       void setVarSwap();
       void setLevelSwap();
+
+      void setChainedUniqueTable();
+      void setOpenUniqueTable();
     }; // end of struct policies
 
     /// Collection of various stats for performance measurement
@@ -2604,6 +2636,7 @@ class MEDDLY::enumerator {
         virtual bool start(const dd_edge &e);
         virtual bool start(const dd_edge &e, const int* m);
         virtual bool next() = 0;
+        virtual bool seek(const int* m);
 
         /**
             Return the highest level changed during the last increment.
@@ -2662,7 +2695,9 @@ class MEDDLY::enumerator {
       EMPTY,
       FULL,       
       ROW_FIXED,
-      COL_FIXED
+      COL_FIXED,
+      /// MDDs with some variables fixed, seekable
+      VARS_FIXED
     };
 
   public:
@@ -2715,6 +2750,28 @@ class MEDDLY::enumerator {
     */
     void startFixedColumn(const dd_edge &e, const int* minterm);
 
+    /** Start iterating through the cofactor of edge e
+        obtained by fixing some of its variables.
+          @param  e         Edge to iterate.
+                            Must not be a relation.
+          @param  minterm   Array of dimension 1+vars in e.
+                            minterm[k] gives the fixed assignment
+                            for variable k, or DONT_CARE if free.
+    */
+    void startFixedVars(const dd_edge &e, const int* minterm);
+
+    /** Move to the first assignment of the edge being iterated,
+        not smaller than the given one in lexicographic order,
+        with the top variable the most significant.
+        Fixed variables keep their values; the enumeration
+        is over if no such assignment exists.
+        Only for VARS_FIXED enumerators.
+          @param  minterm   Array of dimension 1+vars,
+                            where minterm[k] is the lower bound
+                            for variable k.
+    */
+    void seek(const int* minterm);
+
 
     /** Get the current variable assignments.
         For variable i, use index i for the
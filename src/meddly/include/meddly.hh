@@ -250,6 +250,14 @@ inline void MEDDLY::forest::policies::setLevelSwap() {
   swap = variable_swap_type::LEVEL;
 }
 
+inline void MEDDLY::forest::policies::setChainedUniqueTable() {
+  unique_table = unique_table_type::CHAINED;
+}
+
+inline void MEDDLY::forest::policies::setOpenUniqueTable() {
+  unique_table = unique_table_type::OPEN_ADDRESSING;
+}
+
 // end of struct policies
 
 // forest::statset::
@@ -847,7 +847,14 @@ class MEDDLY::unpacked_node {
 
   private:
     const expert_forest* parent;
-    static unpacked_node* freeList;
+    // Recycled nodes are kept per thread, so that threads
+    // reading a frozen forest do not share the list;
+    // each thread releases its own list when it ends.
+    struct recycled_list {
+      unpacked_node* head;
+      ~recycled_list();
+    };
+    static thread_local recycled_list freeList;
     unpacked_node* next; // for recycled list
     /*
       TBD - extra info that is not hashed
@@ -2320,6 +2327,27 @@ class MEDDLY::expert_forest: public forest
     */
     void uncacheNode(node_handle p);
 
+  // --------------------------------------------------
+  // Concurrent reads
+  // --------------------------------------------------
+  public:
+    /** Make the forest read-only.
+        While frozen, several threads may at the same time
+        evaluate existing dd_edges and walk them with enumerators
+        (each thread using its own enumerator), since these only
+        read the node storage and keep their state per thread.
+        Anything else must stay on a single thread:
+        creating, copying or destroying dd_edges changes link counts,
+        and operations create nodes and fill the compute tables.
+        Creating a node throws INVALID_OPERATION,
+        and garbage collection is postponed until the forest is thawed.
+    */
+    void freeze();
+    /// Make the forest writable again; call it after the readers are done.
+    void thaw();
+    /// Returns true if the forest is read-only.
+    bool isFrozen() const;
+
   // --------------------------------------------------
   // Node status
   // --------------------------------------------------
@@ -2692,6 +2720,12 @@ class MEDDLY::expert_forest: public forest
     */
     virtual enumerator::iterator* makeFixedColumnIter() const;
 
+    /**
+        Build an iterator with some variables fixed.
+        Default behavior - throw an "INVALID_FOREST" error.
+    */
+    virtual enumerator::iterator* makeFixedVarsIter() const;
+
     /*
      * Reorganize the variables in a certain order.
      */
@@ -2952,6 +2986,8 @@ class MEDDLY::expert_forest: public forest
   private:
     // Garbage collection in progress
     bool performing_gc;
+    // Read-only, see freeze()
+    bool frozen;
 
     // memory for validating incounts
     node_handle* in_validate;
@@ -4200,6 +4236,15 @@ class MEDDLY::compute_table {
  
           /// Should we remove all CT entries of this type?
           bool isMarkedForDeletion() const;
+
+          /// Number of searches for entries of this type.
+          unsigned long getPings() const;
+
+          /// Number of searches that found an entry of this type.
+          unsigned long getHits() const;
+
+          /// Count a search, done by the compute table.
+          void countSearch(bool hit) const;
         private:
           /// Unique ID, set by compute table
           unsigned etID;
@@ -4237,6 +4282,11 @@ class MEDDLY::compute_table {
 
           bool is_marked_for_deletion;
 
+          /// Searches for entries of this type, in any table.
+          mutable unsigned long pings;
+          /// Searches that found an entry of this type.
+          mutable unsigned long hits;
+
           friend class compute_table;
       };
 
@@ -4439,6 +4489,23 @@ class MEDDLY::compute_table {
       /// Get performance stats for the table.
       const stats& getStats();
 
+      /// Maximum number of slots of the hash table.
+      unsigned getMaxSize() const;
+
+      /** Change the maximum number of slots of the hash table.
+          A larger limit lets a table that reached the old one grow again;
+          a smaller one shrinks the table right away, and the entries
+          that do not fit are discarded.
+          The default only changes the limit.
+      */
+      virtual void setMaxSize(unsigned ms);
+
+      /// Current number of slots of the hash table.
+      virtual unsigned long getTableSize() const = 0;
+
+      /// Memory used by the hash table and its entries, in bytes.
+      virtual size_t getMemUsed() const = 0;
+
       /// For debugging.
       virtual void show(output &s, int verbLevel = 0) = 0;
 
@@ -4590,6 +4657,8 @@ class MEDDLY::operation {
     operation* getNext();
 
     static bool usesMonolithicComputeTable();
+    /// The compute table shared by all operations, or null.
+    static compute_table* getMonolithicComputeTable();
     static void removeStalesFromMonolithic();
     static void removeAllFromMonolithic();
 
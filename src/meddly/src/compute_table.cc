@@ -233,6 +233,13 @@ MEDDLY::compute_table::~compute_table()
 {
 }
 
+void MEDDLY::compute_table::setMaxSize(unsigned ms)
+{
+  if (0==ms)
+    throw error(error::INVALID_ASSIGNMENT, __FILE__, __LINE__);
+  maxSize = ms;
+}
+
 void MEDDLY::compute_table::initialize()
 {
   free_keys = 0;
@@ -427,6 +434,8 @@ MEDDLY::compute_table::entry_type::entry_type(const char* _name, const char* pat
 {
   name = _name;
   is_marked_for_deletion = false;
+  pings = 0;
+  hits = 0;
 
   updatable_result = false;
 
@@ -86,6 +86,11 @@ bool MEDDLY::enumerator::iterator::start(const dd_edge &e, const int* m)
   throw error(error::INVALID_OPERATION, __FILE__, __LINE__);
 }
 
+bool MEDDLY::enumerator::iterator::seek(const int* m)
+{
+  throw error(error::INVALID_OPERATION, __FILE__, __LINE__);
+}
+
 const int* MEDDLY::enumerator::iterator::getPrimedAssignments()
 {
   if (0==F) return 0;
@@ -175,6 +180,10 @@ void MEDDLY::enumerator::init(type t, const forest* f)
       I = F->makeFixedColumnIter();
       break;
 
+    case VARS_FIXED:
+      I = F->makeFixedVarsIter();
+      break;
+
     default:
       I = 0;
       return;
@@ -209,3 +218,19 @@ void MEDDLY::enumerator::startFixedColumn(const dd_edge &e, const int* minterm)
   is_valid = I->start(e, minterm);
 }
 
+void MEDDLY::enumerator::startFixedVars(const dd_edge &e, const int* minterm)
+{
+  if (0==I) return;
+  if (VARS_FIXED != T) throw error(error::MISCELLANEOUS, __FILE__, __LINE__);
+  MEDDLY_DCASSERT(I);
+  is_valid = I->start(e, minterm);
+}
+
+void MEDDLY::enumerator::seek(const int* minterm)
+{
+  if (0==I) return;
+  if (VARS_FIXED != T) throw error(error::MISCELLANEOUS, __FILE__, __LINE__);
+  MEDDLY_DCASSERT(I);
+  is_valid = I->seek(minterm);
+}
+
@@ -95,6 +95,8 @@ void MEDDLY::forest::policies::useDefaults(bool rel)
   orphanTrigger = 500000;
   compactAfterGC = false;
   compactBeforeExpand = true;
+  apply_threads = 1;
+  apply_fork_depth = 2;
 
   // nodemm = ORIGINAL_GRID;
   nodemm = ARRAY_PLUS_GRID;
@@ -107,6 +109,7 @@ void MEDDLY::forest::policies::useDefaults(bool rel)
 
   reorder = reordering_type::SINK_DOWN;
   swap = variable_swap_type::VAR;
+  unique_table = unique_table_type::CHAINED;
 }
 
 // ******************************************************************
@@ -735,6 +738,7 @@ MEDDLY::expert_forest::expert_forest(int ds, domain *d, bool rel, range_type t,
   //
   unique = new unique_table(this);
   performing_gc = false;
+  frozen = false;
   in_validate = 0;
   in_val_size = 0;
   delete_depth = 0;
@@ -1639,7 +1643,7 @@ void MEDDLY::expert_forest::readEdges(input &s, dd_edge* E, int n)
 
 void MEDDLY::expert_forest::garbageCollect()
 {
-  if (performing_gc) return;
+  if (performing_gc || frozen) return;
   performing_gc = true;
   stats.garbage_collections++;
 
@@ -1725,6 +1729,12 @@ MEDDLY::expert_forest::makeFixedColumnIter() const
   throw error(error::TYPE_MISMATCH, __FILE__, __LINE__);
 }
 
+MEDDLY::enumerator::iterator*
+MEDDLY::expert_forest::makeFixedVarsIter() const
+{
+  throw error(error::TYPE_MISMATCH, __FILE__, __LINE__);
+}
+
 const char* MEDDLY::expert_forest::codeChars() const
 {
   return "unknown dd";
@@ -1900,6 +1910,7 @@ void MEDDLY::expert_forest::deleteNode(node_handle p)
 MEDDLY::node_handle MEDDLY::expert_forest
 ::createReducedHelper(int in, unpacked_node &nb)
 {
+  if (frozen) throw error(error::INVALID_OPERATION, __FILE__, __LINE__);
 #ifdef DEVELOPMENT_CODE
   validateDownPointers(nb);
 #endif
@@ -380,3 +380,121 @@ bool MEDDLY::mtmdd_forest::mtmdd_iterator::first(int k, node_handle down)
   index[0] = down;
   return true;
 }
+
+// ******************************************************************
+// *                                                                *
+// *           mtmdd_forest::mtmdd_fixedvars_iter methods           *
+// *                                                                *
+// ******************************************************************
+
+MEDDLY::mtmdd_forest::mtmdd_fixedvars_iter::mtmdd_fixedvars_iter(const expert_forest *F)
+ : mt_iterator(F)
+{
+  fixed = new int[1+maxLevel];
+  for (int k=0; k<=maxLevel; k++) {
+    fixed[k] = DONT_CARE;
+  }
+  root = 0;
+}
+
+MEDDLY::mtmdd_forest::mtmdd_fixedvars_iter::~mtmdd_fixedvars_iter()
+{
+  delete[] fixed;
+}
+
+bool MEDDLY::mtmdd_forest::mtmdd_fixedvars_iter
+::start(const dd_edge &e, const int* minterm)
+{
+  if (F != e.getForest()) {
+    throw error(error::FOREST_MISMATCH, __FILE__, __LINE__);
+  }
+  for (int k=1; k<=maxLevel; k++) {
+    fixed[k] = minterm[k];
+    if (DONT_CARE != fixed[k]) index[k] = fixed[k];
+  }
+  root = e.getNode();
+  level_change = maxLevel;
+  return first(maxLevel, root, 0);
+}
+
+bool MEDDLY::mtmdd_forest::mtmdd_fixedvars_iter::seek(const int* minterm)
+{
+  level_change = maxLevel;
+  return first(maxLevel, root, minterm);
+}
+
+bool MEDDLY::mtmdd_forest::mtmdd_fixedvars_iter::next()
+{
+  MEDDLY_DCASSERT(F);
+  MEDDLY_DCASSERT(!F->isForRelations());
+  MEDDLY_DCASSERT(index);
+  MEDDLY_DCASSERT(nzp);
+  MEDDLY_DCASSERT(path);
+
+  // Only the free levels can advance
+  int k;
+  for (k=1; k<=maxLevel; k++) {
+    if (DONT_CARE != fixed[k]) continue;
+    for (nzp[k]++; nzp[k] < path[k].getNNZs(); nzp[k]++) {
+      index[k] = path[k].i(nzp[k]);
+      level_change = k;
+      if (first(k-1, path[k].d(nzp[k]), 0)) return true;
+    }
+  }
+  level_change = k;
+  return false;
+}
+
+bool MEDDLY::mtmdd_forest::mtmdd_fixedvars_iter
+::first(int k, node_handle down, const int* lower)
+{
+  MEDDLY_DCASSERT(F);
+  MEDDLY_DCASSERT(!F->isForRelations());
+  MEDDLY_DCASSERT(index);
+  MEDDLY_DCASSERT(nzp);
+  MEDDLY_DCASSERT(path);
+
+  if (0==down) return false;
+  if (0==k) {
+    // save the terminal value
+    index[0] = down;
+    return true;
+  }
+
+  int kdn = F->getNodeLevel(down);
+  MEDDLY_DCASSERT(kdn <= k);
+
+  //
+  // Fixed level: follow the one pointer, without unpacking the node
+  //
+  if (DONT_CARE != fixed[k]) {
+    if (lower && fixed[k] < lower[k]) return false;
+    if (lower && fixed[k] > lower[k]) lower = 0;
+    node_handle cdown = (kdn < k) ? down : F->getDownPtr(down, fixed[k]);
+    return first(k-1, cdown, lower);
+  }
+
+  //
+  // Free level: try the children from the lower bound on
+  //
+  if (kdn < k)  path[k].initRedundant(F, k, down, false);
+  else          path[k].initFromNode(F, down, false);
+
+  int z = 0;
+  if (lower) {
+    // indexes of sparse nodes are increasing
+    int hi = path[k].getNNZs();
+    while (z < hi) {
+      int mid = (z + hi) / 2;
+      if (path[k].i(mid) < lower[k]) z = mid+1;
+      else                           hi = mid;
+    }
+  }
+  for ( ; z < path[k].getNNZs(); z++) {
+    nzp[k] = z;
+    index[k] = path[k].i(z);
+    const int* below = (lower && index[k] == lower[k]) ? lower : 0;
+    if (first(k-1, path[k].d(z), below)) return true;
+  }
+  return false;
+}
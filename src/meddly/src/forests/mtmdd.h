@@ -41,6 +41,11 @@ class MEDDLY::mtmdd_forest : public mt_forest {
       return new mtmdd_iterator(this);
     }
 
+    virtual enumerator::iterator* makeFixedVarsIter() const 
+    {
+      return new mtmdd_fixedvars_iter(this);
+    }
+
   protected:
     inline node_handle evaluateRaw(const dd_edge &f, const int* vlist) const {
       node_handle p = f.getNode();
@@ -64,6 +69,24 @@ class MEDDLY::mtmdd_forest : public mt_forest {
       private:
         bool first(int k, node_handle p);
     };
+
+    // Iterator over the cofactor given by some fixed variables,
+    // able to seek forward or backward to any assignment
+    class mtmdd_fixedvars_iter : public mt_iterator {
+      public:
+        mtmdd_fixedvars_iter(const expert_forest* F);
+        virtual ~mtmdd_fixedvars_iter();
+        virtual bool start(const dd_edge &e, const int* m);
+        virtual bool next();
+        virtual bool seek(const int* m);
+      private:
+        // first assignment below level k, not smaller than lower if given
+        bool first(int k, node_handle p, const int* lower);
+      private:
+        // fixed value of each level, DONT_CARE if free
+        int* fixed;
+        node_handle root;
+    };
 };
 
 
@@ -79,7 +79,7 @@ namespace MEDDLY {
 
   //
   // List of free unpacked nodes
-  unpacked_node* unpacked_node::freeList = 0;
+  thread_local unpacked_node::recycled_list unpacked_node::freeList = { 0 };
 
   // helper functions
   void purgeMarkedOperations();
@@ -474,9 +474,9 @@ inline MEDDLY::unpacked_node*
 MEDDLY::unpacked_node::useUnpackedNode()
 {
   unpacked_node* nr;
-  if (freeList) {
-    nr = freeList;
-    freeList = nr->next;
+  if (freeList.head) {
+    nr = freeList.head;
+    freeList.head = nr->next;
   }
   else {
     nr = new unpacked_node;
@@ -491,18 +491,18 @@ inline void
 MEDDLY::unpacked_node::recycle(MEDDLY::unpacked_node* r)
 {
   if (r) {
-    r->next = freeList;
-    freeList = r;
+    r->next = freeList.head;
+    freeList.head = r;
   }
 }
 
 inline void
 MEDDLY::unpacked_node::freeRecycled()
 {
-  while (freeList) {
-    MEDDLY::unpacked_node* n = freeList->next;
-    delete freeList;
-    freeList = n;
+  while (freeList.head) {
+    MEDDLY::unpacked_node* n = freeList.head->next;
+    delete freeList.head;
+    freeList.head = n;
   }
 }
 
@@ -2027,6 +2027,28 @@ MEDDLY::expert_forest::uncacheNode(MEDDLY::node_handle p)
 }
 
 
+// --------------------------------------------------
+// Concurrent reads
+// --------------------------------------------------
+
+inline void
+MEDDLY::expert_forest::freeze()
+{
+  frozen = true;
+}
+
+inline void
+MEDDLY::expert_forest::thaw()
+{
+  frozen = false;
+}
+
+inline bool
+MEDDLY::expert_forest::isFrozen() const
+{
+  return frozen;
+}
+
 // --------------------------------------------------
 // Node status
 // --------------------------------------------------
@@ -3145,6 +3167,22 @@ inline bool MEDDLY::compute_table::entry_type
   return is_marked_for_deletion;
 }
 
+inline unsigned long MEDDLY::compute_table::entry_type::getPings() const
+{
+  return pings;
+}
+
+inline unsigned long MEDDLY::compute_table::entry_type::getHits() const
+{
+  return hits;
+}
+
+inline void MEDDLY::compute_table::entry_type::countSearch(bool hit) const
+{
+  pings++;
+  if (hit) hits++;
+}
+
 // ******************************************************************
 
 // convenience methods, for grabbing edge values
@@ -3198,6 +3236,12 @@ MEDDLY::compute_table::getStats()
   return perf;
 }
 
+inline unsigned
+MEDDLY::compute_table::getMaxSize() const
+{
+  return maxSize;
+}
+
 inline const MEDDLY::compute_table::entry_type*
 MEDDLY::compute_table::getEntryType(operation* op, unsigned slot)
 {
@@ -3277,6 +3321,12 @@ MEDDLY::operation::usesMonolithicComputeTable()
   return Monolithic_CT;
 }
 
+inline MEDDLY::compute_table*
+MEDDLY::operation::getMonolithicComputeTable()
+{
+  return Monolithic_CT;
+}
+
 inline unsigned
 MEDDLY::operation::getIndex() const
 {
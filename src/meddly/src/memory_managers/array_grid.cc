@@ -111,7 +111,8 @@ namespace MEDDLY {
   class array_plus_grid : public hole_manager<INT> {
 
     public:
-      array_plus_grid(const char* n, memstats &stats);
+      array_plus_grid(const char* n, memstats &stats, size_t arena_bytes = 0,
+        bool huge_pages = false);
       virtual ~array_plus_grid();
 
       virtual node_address requestChunk(size_t &numSlots);
@@ -276,8 +277,9 @@ namespace MEDDLY {
 // ******************************************************************
 
 template <class INT>
-MEDDLY::array_plus_grid<INT>::array_plus_grid(const char* n, memstats &stats)
- : hole_manager<INT>(n, stats)
+MEDDLY::array_plus_grid<INT>::array_plus_grid(const char* n, memstats &stats,
+  size_t arena_bytes, bool huge_pages)
+ : hole_manager<INT>(n, stats, arena_bytes, huge_pages)
 {
   // small hole stuff
   num_small_holes = 0;
@@ -1110,3 +1112,59 @@ MEDDLY::array_grid_style::initManager(unsigned char granularity,
   return 0;
 }
 
+
+// ******************************************************************
+// *                                                                *
+// *                                                                *
+// *                      arena_style methods                       *
+// *                                                                *
+// *                                                                *
+// ******************************************************************
+
+size_t MEDDLY::arena_style::budget = 0;
+bool MEDDLY::arena_style::huge_pages = false;
+
+MEDDLY::arena_style::arena_style(const char* n)
+: memory_manager_style(n)
+{
+}
+
+MEDDLY::arena_style::~arena_style()
+{
+}
+
+void MEDDLY::arena_style::setBudget(size_t bytes, bool huge)
+{
+  budget = bytes;
+  huge_pages = huge;
+}
+
+MEDDLY::memory_manager*
+MEDDLY::arena_style::initManager(unsigned char granularity, 
+  unsigned char minsize, memstats &stats) const
+{
+  //
+  // Without a budget, the arena may take all of the physical memory
+  //
+  size_t arena_bytes = budget;
+  if (0==arena_bytes) {
+    arena_bytes = size_t(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+  }
+
+  if (sizeof(int) == granularity) {
+    return new array_plus_grid <int>(getName(), stats, arena_bytes, huge_pages);
+  }
+
+  if (sizeof(long) == granularity) {
+    return new array_plus_grid <long>(getName(), stats, arena_bytes, huge_pages);
+  }
+
+  if (sizeof(short) == granularity) {
+    return new array_plus_grid <short>(getName(), stats, arena_bytes, huge_pages);
+  }
+
+  // unsupported granularity
+
+  return 0;
+}
+
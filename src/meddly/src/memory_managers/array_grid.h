@@ -23,6 +23,7 @@
 
 namespace MEDDLY {
   class array_grid_style;
+  class arena_style;
 };
 
 /**
@@ -42,5 +43,32 @@ class MEDDLY::array_grid_style : public memory_manager_style {
       unsigned char minsize, memstats &stats) const;
 };
 
+/**
+    Factory for the same memory manager, keeping its array
+    in an mmap arena instead of growing it with realloc.
+
+    The arena takes the budget set with setArenaBudget(),
+    or the size of the physical memory if none is set,
+    and requests past it fail: node storage then throws
+    error::INSUFFICIENT_MEMORY.
+    The budget is read when a manager is built,
+    i.e. when a forest is created.
+*/
+
+class MEDDLY::arena_style : public memory_manager_style {
+  public:
+    arena_style(const char* n);
+    virtual ~arena_style();
+
+    virtual memory_manager* initManager(unsigned char granularity,
+      unsigned char minsize, memstats &stats) const;
+
+    static void setBudget(size_t bytes, bool huge);
+
+  private:
+    static size_t budget;
+    static bool huge_pages;
+};
+
 #endif
 
@@ -26,6 +26,9 @@
 #include "../defines.h"
 #include "orig_grid.h"
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 #if 0
 #ifdef HAVE_MALLOC_GOOD_SIZE
 #include <malloc/malloc.h>
@@ -54,11 +57,19 @@ namespace MEDDLY {
       First slot is the hole sizze, with MSB set
       Last slot is the hole size, with MSB set
 
+    The array is either grown with realloc, or, with a nonzero arena size,
+    kept in one mmap region of that many bytes, reserved at the first request.
+    The arena never moves, its pages are touched only when used,
+    and those past the last used slot are given back to the OS
+    once the array uses less than a third of them.
+    Requests that do not fit in the arena fail.
+
   */
   template <class INT>
   class hole_manager : public memory_manager {
     public:
-      hole_manager(const char* n, memstats &stats);
+      hole_manager(const char* n, memstats &stats, size_t arena_bytes = 0,
+        bool huge_pages = false);
       virtual ~hole_manager();
 
       // common stuff!
@@ -122,6 +133,9 @@ namespace MEDDLY {
           printf("\tMerging chunk with unused end bit\n");
 #endif
           last_used_slot = addr-1;
+          if (arena_bytes && data_alloc > 3 * (last_used_slot+1)) {
+            releaseArenaTail();
+          }
           return true;
         } else {
           return false;
@@ -179,11 +193,22 @@ namespace MEDDLY {
       /// @return true on success
       bool resize(size_t newalloc);
 
+      /// Reserve the arena; @return true on success
+      bool reserveArena();
+
+      /// Give the pages past the end of the array back to the OS
+      void releaseArenaTail();
+
     private:
       INT* data;
       node_address data_alloc;
       node_address last_used_slot;
 
+      /// Size of the mmap arena, 0 if the array is realloc'd
+      size_t arena_bytes;
+      /// Back the arena with transparent huge pages, where available
+      bool huge_pages;
+
       INT MSB;
 
   }; // class hole_manager
@@ -199,12 +224,15 @@ namespace MEDDLY {
 // ******************************************************************
 
 template <class INT>
-MEDDLY::hole_manager<INT>::hole_manager(const char* n, memstats &stats)
+MEDDLY::hole_manager<INT>::hole_manager(const char* n, memstats &stats,
+  size_t arena_bytes, bool huge_pages)
   : memory_manager(n, stats)
 {
   data = 0;
   data_alloc = 0;
   last_used_slot = 0;
+  this->arena_bytes = arena_bytes;
+  this->huge_pages = huge_pages;
 
   MSB = 1;
   MSB <<= (8*sizeof(INT) - 1);
@@ -220,7 +248,11 @@ template <class INT>
 MEDDLY::hole_manager<INT>::~hole_manager()
 {
   decMemAlloc(data_alloc * sizeof(INT));
-  free(data);
+  if (arena_bytes) {
+    if (data) munmap(data, arena_bytes);
+  } else {
+    free(data);
+  }
 }
 
 // ******************************************************************
@@ -288,7 +320,7 @@ MEDDLY::node_address MEDDLY::hole_manager<INT>::allocateFromArray(size_t numSlot
       ok = resize(want_size);
     }
 
-    if (!ok) {
+    if (!ok || last_used_slot + numSlots >= data_alloc) {
       //
       // Couldn't resize, fail cleanly
       //
@@ -325,6 +357,28 @@ bool MEDDLY::hole_manager<INT>::resize(size_t new_alloc)
   printf(" data %lx, new size %ld\n", (unsigned long)data, new_alloc);
 #endif
 
+  if (arena_bytes) {
+    //
+    // Nothing moves: just account for the slots the array may use now,
+    // as many as fit in the arena
+    //
+    if (0==data && !reserveArena()) {
+      return false;
+    }
+    size_t max_alloc = arena_bytes / sizeof(INT);
+    if (new_alloc > max_alloc) new_alloc = max_alloc;
+    if (new_alloc <= size_t(last_used_slot)) {
+      return false;
+    }
+    if (new_alloc > size_t(data_alloc)) {
+      incMemAlloc((new_alloc - data_alloc) * sizeof(INT));
+    } else {
+      decMemAlloc((data_alloc - new_alloc) * sizeof(INT));
+    }
+    data_alloc = new_alloc;
+    return true;
+  }
+
   INT* new_data = (INT*) realloc(data, new_alloc * sizeof(INT));
 
 #ifdef TRACE_REALLOCS
@@ -356,5 +410,55 @@ bool MEDDLY::hole_manager<INT>::resize(size_t new_alloc)
 
 // ******************************************************************
 
+template <class INT>
+bool MEDDLY::hole_manager<INT>::reserveArena()
+{
+  //
+  // Address space only: pages are backed by memory once written
+  //
+  void* arena = mmap(0, arena_bytes, PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (MAP_FAILED == arena) {
+    return false;
+  }
+#ifdef MADV_HUGEPAGE
+  if (huge_pages) madvise(arena, arena_bytes, MADV_HUGEPAGE);
+#endif
+  data = (INT*) arena;
+  data[0] = 0;
+
+#ifndef USE_SLOW_GET_CHUNK_ADDRESS
+  setChunkBase(data);
+#endif
+
+  return true;
+}
+
+// ******************************************************************
+
+template <class INT>
+void MEDDLY::hole_manager<INT>::releaseArenaTail()
+{
+  //
+  // Keep half the slack past the end of the array, and release whole
+  // huge pages if the arena uses them, so that the remaining ones stay huge
+  //
+  const size_t unit = huge_pages ? (2 << 20) : sysconf(_SC_PAGESIZE);
+  size_t keep = (last_used_slot + 1) + (data_alloc - last_used_slot - 1) / 2;
+  size_t from = (keep * sizeof(INT) + unit - 1) / unit * unit;
+  size_t to = data_alloc * sizeof(INT);
+  if (from >= to) return;
+
+#ifdef TRACE_REALLOCS
+  printf("releasing arena bytes %ld to %ld\n", long(from), long(to));
+#endif
+
+  madvise((char*) data + from, to - from, MADV_DONTNEED);
+  decMemAlloc(to - from);
+  data_alloc = from / sizeof(INT);
+}
+
+// ******************************************************************
+
 #endif  // #include guard
 
@@ -35,8 +35,14 @@ namespace MEDDLY {
   const memory_manager_style* MALLOC_MANAGER = 0;
   const memory_manager_style* HEAP_MANAGER = 0;
   const memory_manager_style* FREELISTS = 0;
+  const memory_manager_style* ARENA_MANAGER = 0;
 };
 
+void MEDDLY::setArenaBudget(size_t bytes, bool huge_pages)
+{
+  arena_style::setBudget(bytes, huge_pages);
+}
+
 
 
 
@@ -48,6 +54,7 @@ MEDDLY::memman_initializer::memman_initializer(initializer_list *p)
   malloc_manager = 0;
   heap_manager = 0;
   freelists = 0;
+  arena_manager = 0;
 }
 
 void MEDDLY::memman_initializer::setup()
@@ -57,6 +64,7 @@ void MEDDLY::memman_initializer::setup()
   MALLOC_MANAGER = (malloc_manager = new malloc_style("MALLOC_MANAGER"));
   HEAP_MANAGER = (heap_manager = new heap_style("HEAP_MANAGER"));
   FREELISTS = (freelists = new freelist_style("FREELISTS"));
+  ARENA_MANAGER = (arena_manager = new arena_style("ARENA_MANAGER"));
 }
 
 void MEDDLY::memman_initializer::cleanup()
@@ -66,10 +74,12 @@ void MEDDLY::memman_initializer::cleanup()
   delete malloc_manager;
   delete heap_manager;
   delete freelists;
+  delete arena_manager;
   ORIGINAL_GRID = (original_grid  = 0);
   ARRAY_PLUS_GRID = (array_plus_grid  = 0);
   MALLOC_MANAGER = (malloc_manager  = 0);
   HEAP_MANAGER = (heap_manager  = 0);
   FREELISTS = (freelists = 0);
+  ARENA_MANAGER = (arena_manager = 0);
 }
 
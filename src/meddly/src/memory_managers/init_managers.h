@@ -28,6 +28,7 @@ class MEDDLY::memman_initializer : public initializer_list {
     memory_manager_style* malloc_manager;
     memory_manager_style* heap_manager;
     memory_manager_style* freelists;
+    memory_manager_style* arena_manager;
 
   public:
     memman_initializer(initializer_list *p);
@@ -61,6 +61,11 @@ MEDDLY::unpacked_node::~unpacked_node()
   clear();
 }
 
+MEDDLY::unpacked_node::recycled_list::~recycled_list()
+{
+  freeRecycled();
+}
+
 void MEDDLY::unpacked_node::clear()
 {
   free(extra_unhashed);
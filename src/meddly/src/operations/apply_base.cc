@@ -24,6 +24,12 @@
 #include "../forests/mt.h"
 #include "apply_base.h"
 
+#include <atomic>
+#include <exception>
+#include <set>
+#include <thread>
+#include <unordered_map>
+
 // #define TRACE_ALL_OPS
 // #define DISABLE_CACHE
 
@@ -54,7 +60,17 @@ MEDDLY::generic_binary_mdd::~generic_binary_mdd()
 void MEDDLY::generic_binary_mdd::computeDDEdge(const dd_edge &a, const dd_edge &b, 
   dd_edge &c)
 {
-  node_handle cnode = compute(a.getNode(), b.getNode());
+  // the parallel apply builds fully reduced nodes, on levels that are not extensible
+  const int nthreads = resF->getPolicies().apply_threads;
+  bool parallel = nthreads > 1 && allowsParallel() && resF->isFullyReduced()
+    && !resF->isFrozen() && !arg1F->isFrozen() && !arg2F->isFrozen();
+  for (int k = resF->getNumVariables(); parallel && k > 0; k--) {
+    parallel = !resF->isExtensibleLevel(k);
+  }
+
+  node_handle cnode = parallel
+    ? computeParallel(a.getNode(), b.getNode(), nthreads)
+    : compute(a.getNode(), b.getNode());
   const int num_levels = resF->getDomain()->getNumVariables();
   if (resF->isQuasiReduced() && cnode != resF->getTransparentNode()
     && resF->getNodeLevel(cnode) < num_levels) {
@@ -159,6 +175,261 @@ MEDDLY::generic_binary_mdd::compute_normal(node_handle a, node_handle b)
   return result;
 }
 
+bool MEDDLY::generic_binary_mdd::allowsParallel() const
+{
+  return false;
+}
+
+bool MEDDLY::generic_binary_mdd::checkTerminalsUnlinked(node_handle a, 
+  node_handle b, node_handle& c)
+{
+  throw error(error::NOT_IMPLEMENTED, __FILE__, __LINE__);
+}
+
+// ******************************************************************
+// *                                                                *
+// *            generic_binary_mdd::parallel_worker class           *
+// *                                                                *
+// ******************************************************************
+
+/*
+    Computes node pairs of a generic_binary_mdd on its own thread,
+    while the forests are frozen. The nodes of the results are kept
+    in private unique and compute tables, and copied into the result
+    forest by materialize() once all the threads are done.
+*/
+class MEDDLY::generic_binary_mdd::parallel_worker {
+  public:
+    // Either a node handle of the result forest,
+    // or LOCAL plus the index of a private node.
+    typedef long ref;
+    static const ref LOCAL = 1L << 32;
+
+    parallel_worker(generic_binary_mdd* op) : op(op) { }
+
+    ref compute(node_handle a, node_handle b);
+
+    // Create the private nodes in the result forest, children first.
+    void materialize();
+    // Returns a linked handle for r; call after materialize().
+    node_handle link(ref r) const;
+    // Unlink the nodes created by materialize().
+    void release();
+
+  private:
+    typedef std::pair<int, std::vector<ref> > node_key;
+
+    struct node_key_hash {
+      size_t operator()(const node_key& k) const {
+        size_t h = k.first;
+        for (size_t i = 0; i < k.second.size(); i++) {
+          h = h * 1000003 ^ std::hash<ref>()(k.second[i]);
+        }
+        return h;
+      }
+    };
+
+    struct pair_hash {
+      size_t operator()(const std::pair<node_handle, node_handle>& p) const {
+        return size_t(p.first) * 1000003 ^ size_t(p.second);
+      }
+    };
+
+    generic_binary_mdd* op;
+    std::unordered_map<node_key, ref, node_key_hash> unique;
+    std::unordered_map<std::pair<node_handle, node_handle>, ref, pair_hash> results;
+    // private nodes, in creation order
+    std::vector<const node_key*> nodes;
+    // their handles in the result forest
+    std::vector<node_handle> handles;
+};
+
+MEDDLY::generic_binary_mdd::parallel_worker::ref
+MEDDLY::generic_binary_mdd::parallel_worker::compute(node_handle a, node_handle b)
+{
+  node_handle c;
+  if (op->checkTerminalsUnlinked(a, b, c)) return c;
+
+  if (op->can_commute && a > b) std::swap(a, b);
+  std::pair<node_handle, node_handle> key(a, b);
+  auto found = results.find(key);
+  if (found != results.end()) return found->second;
+
+  const int aLevel = op->arg1F->getNodeLevel(a);
+  const int bLevel = op->arg2F->getNodeLevel(b);
+  const int resultLevel = MAX(aLevel, bLevel);
+  const int resultSize = op->resF->getLevelSize(resultLevel);
+
+  unpacked_node *A = (aLevel < resultLevel) 
+    ? unpacked_node::newRedundant(op->arg1F, resultLevel, a, true)
+    : unpacked_node::newFromNode(op->arg1F, a, true)
+  ;
+  unpacked_node *B = (bLevel < resultLevel)
+    ? unpacked_node::newRedundant(op->arg2F, resultLevel, b, true)
+    : unpacked_node::newFromNode(op->arg2F, b, true)
+  ;
+
+  std::vector<ref> down(resultSize);
+  bool redundant = true;
+  for (int i=0; i<resultSize; i++) {
+    down[i] = compute(A->d(i), B->d(i));
+    redundant = redundant && down[i] == down[0];
+  }
+
+  unpacked_node::recycle(B);
+  unpacked_node::recycle(A);
+
+  // same reductions as the forest: redundant nodes are skipped, 
+  // duplicates of the private nodes are shared; duplicates of 
+  // forest nodes are found by materialize()
+  ref result = down[0];
+  if (!redundant) {
+    auto inserted = unique.emplace(node_key(resultLevel, down), LOCAL + nodes.size());
+    if (inserted.second) nodes.push_back(&inserted.first->first);
+    result = inserted.first->second;
+  }
+  results.emplace(key, result);
+  return result;
+}
+
+void MEDDLY::generic_binary_mdd::parallel_worker::materialize()
+{
+  handles.resize(nodes.size());
+  for (size_t i=0; i<nodes.size(); i++) {
+    const std::vector<ref>& down = nodes[i]->second;
+    unpacked_node* C = unpacked_node::newFull(op->resF, nodes[i]->first, down.size());
+    for (size_t j=0; j<down.size(); j++) {
+      C->d_ref(j) = link(down[j]);
+    }
+    handles[i] = op->resF->createReducedNode(-1, C);
+  }
+}
+
+MEDDLY::node_handle
+MEDDLY::generic_binary_mdd::parallel_worker::link(ref r) const
+{
+  return op->resF->linkNode(r >= LOCAL ? handles[r - LOCAL] : node_handle(r));
+}
+
+void MEDDLY::generic_binary_mdd::parallel_worker::release()
+{
+  for (size_t i=0; i<handles.size(); i++) {
+    op->resF->unlinkNode(handles[i]);
+  }
+  handles.clear();
+}
+
+// ******************************************************************
+
+MEDDLY::node_handle 
+MEDDLY::generic_binary_mdd::computeParallel(node_handle a, node_handle b, 
+  int nthreads)
+{
+  typedef std::pair<node_handle, node_handle> node_pair;
+
+  // node pairs below the top one; pairs ending in a terminal case are left
+  // to the sequential apply, as the pairs of the levels above
+  std::set<node_pair> frontier;
+  frontier.insert(node_pair(a, b));
+  for (int depth = resF->getPolicies().apply_fork_depth; depth > 0; depth--) {
+    std::set<node_pair> below;
+    for (std::set<node_pair>::iterator it = frontier.begin(); it != frontier.end(); ++it) {
+      node_handle c;
+      if (checkTerminalsUnlinked(it->first, it->second, c)) continue;
+
+      const int aLevel = arg1F->getNodeLevel(it->first);
+      const int bLevel = arg2F->getNodeLevel(it->second);
+      const int resultLevel = MAX(aLevel, bLevel);
+      unpacked_node *A = (aLevel < resultLevel) 
+        ? unpacked_node::newRedundant(arg1F, resultLevel, it->first, true)
+        : unpacked_node::newFromNode(arg1F, it->first, true)
+      ;
+      unpacked_node *B = (bLevel < resultLevel)
+        ? unpacked_node::newRedundant(arg2F, resultLevel, it->second, true)
+        : unpacked_node::newFromNode(arg2F, it->second, true)
+      ;
+      for (int i=0; i<A->getSize(); i++) {
+        below.insert(node_pair(A->d(i), B->d(i)));
+      }
+      unpacked_node::recycle(B);
+      unpacked_node::recycle(A);
+    }
+    frontier.swap(below);
+  }
+
+  std::vector<node_pair> tasks;
+  for (std::set<node_pair>::iterator it = frontier.begin(); it != frontier.end(); ++it) {
+    node_handle c;
+    if (!checkTerminalsUnlinked(it->first, it->second, c)) tasks.push_back(*it);
+  }
+
+  // each thread takes the next task when done with the previous one
+  std::vector<parallel_worker*> workers(nthreads);
+  std::vector<parallel_worker::ref> task_results(tasks.size());
+  std::vector<int> task_workers(tasks.size());
+  std::vector<std::exception_ptr> errors(nthreads);
+  std::vector<std::thread> threads;
+  std::atomic<size_t> next_task(0);
+
+  for (int w=0; w<nthreads; w++) {
+    workers[w] = new parallel_worker(this);
+  }
+  arg1F->freeze();
+  arg2F->freeze();
+  resF->freeze();
+  for (int w=0; w<nthreads; w++) {
+    threads.push_back(std::thread([&, w]() {
+      try {
+        for (size_t t = next_task++; t < tasks.size(); t = next_task++) {
+          task_results[t] = workers[w]->compute(tasks[t].first, tasks[t].second);
+          task_workers[t] = w;
+        }
+      }
+      catch (...) {
+        errors[w] = std::current_exception();
+      }
+    }));
+  }
+  for (int w=0; w<nthreads; w++) {
+    threads[w].join();
+  }
+  arg1F->thaw();
+  arg2F->thaw();
+  resF->thaw();
+
+  for (int w=0; w<nthreads; w++) {
+    if (errors[w]) {
+      for (int v=0; v<nthreads; v++) delete workers[v];
+      std::rethrow_exception(errors[w]);
+    }
+  }
+
+  // the results of the tasks are saved in the compute table,
+  // where the sequential apply of the top levels finds them
+  std::vector<node_handle> task_nodes(tasks.size());
+  for (int w=0; w<nthreads; w++) {
+    workers[w]->materialize();
+  }
+  for (size_t t=0; t<tasks.size(); t++) {
+    node_handle cached;
+    task_nodes[t] = workers[task_workers[t]]->link(task_results[t]);
+    compute_table::entry_key* Key = findResult(tasks[t].first, tasks[t].second, cached);
+    if (Key) saveResult(Key, tasks[t].first, tasks[t].second, task_nodes[t]);
+    else resF->unlinkNode(cached);
+  }
+  for (int w=0; w<nthreads; w++) {
+    workers[w]->release();
+    delete workers[w];
+  }
+
+  node_handle result = compute(a, b);
+
+  for (size_t t=0; t<tasks.size(); t++) {
+    resF->unlinkNode(task_nodes[t]);
+  }
+  return result;
+}
+
 #ifdef USING_SPARSE
 
 MEDDLY::node_handle 
@@ -83,7 +83,22 @@ class MEDDLY::generic_binary_mdd : public binary_operation {
     // If terminal condition is reached, returns true and the result in c.
     // Must be provided in derived classes.
     virtual bool checkTerminals(node_handle a, node_handle b, node_handle& c) = 0;
-    
+
+    // Same as checkTerminals, but c is not linked: it can be called
+    // by several threads while the forests are frozen.
+    // Derived classes providing it can run on several threads,
+    // see forest::policies::apply_threads.
+    virtual bool allowsParallel() const;
+    virtual bool checkTerminalsUnlinked(node_handle a, node_handle b, node_handle& c);
+
+  private:
+    class parallel_worker;
+
+    // Parallel apply: the node pairs apply_fork_depth levels below
+    // the top one are computed by the threads into private node tables,
+    // copied into the forest and the compute table afterwards;
+    // the levels above are then computed as usual.
+    node_handle computeParallel(node_handle a, node_handle b, int nthreads);
 };
 
 // ******************************************************************
@@ -46,6 +46,8 @@ class MEDDLY::multiply_mdd : public generic_binary_mdd {
 
   protected:
     virtual bool checkTerminals(node_handle a, node_handle b, node_handle& c);
+    virtual bool allowsParallel() const;
+    virtual bool checkTerminalsUnlinked(node_handle a, node_handle b, node_handle& c);
 };
 
 MEDDLY::multiply_mdd::multiply_mdd(const binary_opname* opcode, 
@@ -56,6 +58,18 @@ MEDDLY::multiply_mdd::multiply_mdd(const binary_opname* opcode,
 }
 
 bool MEDDLY::multiply_mdd::checkTerminals(node_handle a, node_handle b, node_handle& c)
+{
+  if (!checkTerminalsUnlinked(a, b, c)) return false;
+  c = resF->linkNode(c);
+  return true;
+}
+
+bool MEDDLY::multiply_mdd::allowsParallel() const
+{
+  return true;
+}
+
+bool MEDDLY::multiply_mdd::checkTerminalsUnlinked(node_handle a, node_handle b, node_handle& c)
 {
   if (a == 0 || b == 0) {
     c = 0;
@@ -80,13 +94,13 @@ bool MEDDLY::multiply_mdd::checkTerminals(node_handle a, node_handle b, node_han
     if (arg2F != resF) return false;
     if (resF->getRangeType() == forest::INTEGER) {
       if (1==arg1F->getIntegerFromHandle(a)) {
-        c = arg2F->linkNode(b);
+        c = b;
         return true;
       }
     } else {
       MEDDLY_DCASSERT(resF->getRangeType() == forest::REAL);
       if (1.0==arg1F->getRealFromHandle(a)) {
-        c = arg2F->linkNode(b);
+        c = b;
         return true;
       }
     }
@@ -95,13 +109,13 @@ bool MEDDLY::multiply_mdd::checkTerminals(node_handle a, node_handle b, node_han
     if (arg1F != resF) return false;
     if (resF->getRangeType() == forest::INTEGER) {
       if (1==arg2F->getIntegerFromHandle(b)) {
-        c = arg1F->linkNode(a);
+        c = a;
         return true;
       }
     } else {
       MEDDLY_DCASSERT(resF->getRangeType() == forest::REAL);
       if (1.0==arg2F->getRealFromHandle(b)) {
-        c = arg1F->linkNode(a);
+        c = a;
         return true;
       }
     }
@@ -46,6 +46,8 @@ class MEDDLY::plus_mdd : public generic_binary_mdd {
 
   protected:
     virtual bool checkTerminals(node_handle a, node_handle b, node_handle& c);
+    virtual bool allowsParallel() const;
+    virtual bool checkTerminalsUnlinked(node_handle a, node_handle b, node_handle& c);
 };
 
 MEDDLY::plus_mdd::plus_mdd(const binary_opname* opcode, 
@@ -56,6 +58,18 @@ MEDDLY::plus_mdd::plus_mdd(const binary_opname* opcode,
 }
 
 bool MEDDLY::plus_mdd::checkTerminals(node_handle a, node_handle b, node_handle& c)
+{
+  if (!checkTerminalsUnlinked(a, b, c)) return false;
+  c = resF->linkNode(c);
+  return true;
+}
+
+bool MEDDLY::plus_mdd::allowsParallel() const
+{
+  return true;
+}
+
+bool MEDDLY::plus_mdd::checkTerminalsUnlinked(node_handle a, node_handle b, node_handle& c)
 {
   if (arg1F->isTerminalNode(a) && arg2F->isTerminalNode(b)) {
     if (resF->getRangeType() == forest::INTEGER) {
@@ -74,14 +88,14 @@ bool MEDDLY::plus_mdd::checkTerminals(node_handle a, node_handle b, node_handle&
   }
   if (0==a) {
     if (arg2F == resF) {
-      c = arg2F->linkNode(b);
+      c = b;
       return true;
     }
     return false;
   }
   if (0==b) {
     if (arg1F == resF) {
-      c = arg1F->linkNode(a);
+      c = a;
       return true;
     }
     return false;
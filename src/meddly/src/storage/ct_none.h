@@ -54,6 +54,9 @@ namespace MEDDLY {
       virtual void removeAll();
       virtual void show(output &s, int verbLevel = 0);
       virtual void countNodeEntries(const expert_forest* f, size_t* counts) const;
+      virtual void setMaxSize(unsigned ms);
+      virtual unsigned long getTableSize() const  { return tableSize; }
+      virtual size_t getMemUsed() const           { return mstats.getMemUsed(); }
 
     private:  // helper methods
 
@@ -654,6 +657,7 @@ void MEDDLY::ct_none<MONOLITHIC, CHAINED>
 
   entry_item* entry_result = findEntry(key);
   perf.pings++;
+  key->getET()->countSearch(entry_result != 0);
 
   if (entry_result) {
     perf.hits++;
@@ -1004,6 +1008,68 @@ void MEDDLY::ct_none<MONOLITHIC, CHAINED>::removeStales()
 
 // **********************************************************************
 
+template <bool MONOLITHIC, bool CHAINED>
+void MEDDLY::ct_none<MONOLITHIC, CHAINED>::setMaxSize(unsigned ms)
+{
+  compute_table::setMaxSize(ms);
+  if (maxSize < 1024) maxSize = 1024;
+
+  if (tableSize > maxSize) {
+    //
+    // Shrink table to the new limit
+    //
+    if (CHAINED) {
+      unsigned long list = convertToList(checkStalesOnResize);
+      unsigned long* newt = (unsigned long*) realloc(table, maxSize * sizeof(unsigned long));
+      if (0==newt) {
+        throw error(error::INSUFFICIENT_MEMORY, __FILE__, __LINE__);
+      }
+
+      mstats.decMemUsed( (tableSize - maxSize) * sizeof(unsigned long) );
+      mstats.decMemAlloc( (tableSize - maxSize) * sizeof(unsigned long) );
+
+      table = newt;
+      tableSize = maxSize;
+      listToTable(list);
+    } else {
+      unsigned long* oldT = table;
+      unsigned long oldSize = tableSize;
+      tableSize = maxSize;
+      table = (unsigned long*) malloc(tableSize * sizeof(unsigned long));
+      if (0==table) {
+        table = oldT;
+        tableSize = oldSize;
+        throw error(error::INSUFFICIENT_MEMORY, __FILE__, __LINE__);
+      }
+      for (unsigned long i=0; i<tableSize; i++) table[i] = 0;
+      mstats.incMemUsed(tableSize * sizeof(unsigned long));
+      mstats.incMemAlloc(tableSize * sizeof(unsigned long));
+
+      rehashTable(oldT, oldSize);
+      free(oldT);
+
+      mstats.decMemUsed(oldSize * sizeof(unsigned long));
+      mstats.decMemAlloc(oldSize * sizeof(unsigned long));
+    }
+  }
+
+  //
+  // Same thresholds as after a resize, so a full table can grow again
+  //
+  if (tableSize == maxSize) {
+    tableExpand = std::numeric_limits<int>::max();
+  } else {
+    tableExpand = CHAINED ? 4*tableSize : tableSize / 2;
+  }
+  if (1024 == tableSize) {
+    tableShrink = 0;
+  } else {
+    tableShrink = CHAINED ? tableSize / 2 : tableSize / 8;
+  }
+}
+
+// **********************************************************************
+
 template <bool MONOLITHIC, bool CHAINED>
 void MEDDLY::ct_none<MONOLITHIC, CHAINED>::removeAll()
 {
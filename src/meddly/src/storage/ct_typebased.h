@@ -54,6 +54,9 @@ namespace MEDDLY {
       virtual void removeAll();
       virtual void show(output &s, int verbLevel = 0);
       virtual void countNodeEntries(const expert_forest* f, size_t* counts) const;
+      virtual void setMaxSize(unsigned ms);
+      virtual unsigned long getTableSize() const  { return tableSize; }
+      virtual size_t getMemUsed() const           { return mstats.getMemUsed(); }
 
     private:  // helper methods
 
@@ -751,6 +754,7 @@ void MEDDLY::ct_typebased<MONOLITHIC, CHAINED>
 
   int* entry_result = findEntry(key);
   perf.pings++;
+  et->countSearch(entry_result != 0);
 
   if (entry_result) {
     perf.hits++;
@@ -1130,6 +1134,68 @@ void MEDDLY::ct_typebased<MONOLITHIC, CHAINED>::removeStales()
 
 // **********************************************************************
 
+template <bool MONOLITHIC, bool CHAINED>
+void MEDDLY::ct_typebased<MONOLITHIC, CHAINED>::setMaxSize(unsigned ms)
+{
+  compute_table::setMaxSize(ms);
+  if (maxSize < 1024) maxSize = 1024;
+
+  if (tableSize > maxSize) {
+    //
+    // Shrink table to the new limit
+    //
+    if (CHAINED) {
+      int list = convertToList(checkStalesOnResize);
+      int* newt = (int*) realloc(table, maxSize * sizeof(int));
+      if (0==newt) {
+        throw error(error::INSUFFICIENT_MEMORY, __FILE__, __LINE__);
+      }
+
+      mstats.decMemUsed( (tableSize - maxSize) * sizeof(int) );
+      mstats.decMemAlloc( (tableSize - maxSize) * sizeof(int) );
+
+      table = newt;
+      tableSize = maxSize;
+      listToTable(list);
+    } else {
+      int* oldT = table;
+      unsigned oldSize = tableSize;
+      tableSize = maxSize;
+      table = (int*) malloc(tableSize * sizeof(int));
+      if (0==table) {
+        table = oldT;
+        tableSize = oldSize;
+        throw error(error::INSUFFICIENT_MEMORY, __FILE__, __LINE__);
+      }
+      for (unsigned i=0; i<tableSize; i++) table[i] = 0;
+      mstats.incMemUsed(tableSize * sizeof(int));
+      mstats.incMemAlloc(tableSize * sizeof(int));
+
+      rehashTable(oldT, oldSize);
+      free(oldT);
+
+      mstats.decMemUsed(oldSize * sizeof(int));
+      mstats.decMemAlloc(oldSize * sizeof(int));
+    }
+  }
+
+  //
+  // Same thresholds as after a resize, so a full table can grow again
+  //
+  if (tableSize == maxSize) {
+    tableExpand = std::numeric_limits<int>::max();
+  } else {
+    tableExpand = CHAINED ? 4*tableSize : tableSize / 2;
+  }
+  if (1024 == tableSize) {
+    tableShrink = 0;
+  } else {
+    tableShrink = CHAINED ? tableSize / 2 : tableSize / 8;
+  }
+}
+
+// **********************************************************************
+
 template <bool MONOLITHIC, bool CHAINED>
 void MEDDLY::ct_typebased<MONOLITHIC, CHAINED>::removeAll()
 {
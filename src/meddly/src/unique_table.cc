@@ -142,7 +142,7 @@ void MEDDLY::unique_table::show(output &s) const
 }
 
 MEDDLY::unique_table::subtable::subtable()
-: parent(nullptr), table(nullptr)
+: parent(nullptr), table(nullptr), hashes(nullptr)
 {
 }
 
@@ -150,6 +150,7 @@ MEDDLY::unique_table::subtable::~subtable()
 {
   if (parent != nullptr) {
     free(table);
+    free(hashes);
   }
 }
 
@@ -165,7 +166,10 @@ void MEDDLY::unique_table::subtable::reportStats(output &s, const char* pad, uns
 void MEDDLY::unique_table::subtable::show(output &s) const
 {
   for (unsigned i=0; i < size; i++) {
-    if(table[i] != 0) {
+    if (table[i] != 0 && hashes) {
+      s << "[" << long(i) << "] : " << table[i] << "\n";
+    }
+    else if(table[i] != 0) {
       s << "[" << long(i) << "] : ";
       for (int index = table[i]; index; index = parent->getNext(index)) {
         s << index <<" ";
@@ -187,7 +191,16 @@ void MEDDLY::unique_table::subtable::init(expert_forest *ef)
     throw error(error::INSUFFICIENT_MEMORY, __FILE__, __LINE__);
   }
 
-  next_expand = 2 * size;
+  if (parent->getPolicies().unique_table == forest::policies::unique_table_type::OPEN_ADDRESSING) {
+    hashes = static_cast<unsigned*>(malloc(size * sizeof(unsigned)));
+    if (hashes == nullptr) {
+      throw error(error::INSUFFICIENT_MEMORY, __FILE__, __LINE__);
+    }
+    // at most half full, so that the probe sequences stay short
+    next_expand = size / 2;
+  } else {
+    next_expand = 2 * size;
+  }
   next_shrink = 0;
 }
 
@@ -195,6 +208,24 @@ void MEDDLY::unique_table::subtable::add(unsigned hash, node_handle item)
 {
   MEDDLY_DCASSERT(item>0);
 
+  if (hashes) {
+    if (num_entries >= next_expand) {
+      resizeOpen(size * 2);
+    }
+    num_entries++;
+
+    unsigned h = hash & (size-1);
+    while (table[h] != 0) {
+      h = (h+1) & (size-1);
+    }
+    table[h] = item;
+    hashes[h] = hash;
+    // the storage expects a non-negative next pointer in active nodes
+    if(!parent->isImplicit(item))
+      parent->setNext(item, 0);
+    return;
+  }
+
   if (num_entries >= next_expand){
     expand();
   }
@@ -208,6 +239,32 @@ void MEDDLY::unique_table::subtable::add(unsigned hash, node_handle item)
 
 MEDDLY::node_handle MEDDLY::unique_table::subtable::remove(unsigned hash, node_handle item)
 {
+  if (hashes) {
+    const unsigned mask = size-1;
+    unsigned i = hash & mask;
+    for (; table[i] != item; i = (i+1) & mask) {
+      if (table[i] == 0) {
+        MEDDLY_DCASSERT(false);
+        return 0;
+      }
+    }
+    // shift back the following items of the cluster that may take the free slot,
+    // i.e. those whose probe sequence starts before it
+    for (unsigned j = (i+1) & mask; table[j] != 0; j = (j+1) & mask) {
+      if (((j - hashes[j]) & mask) >= ((j - i) & mask)) {
+        table[i] = table[j];
+        hashes[i] = hashes[j];
+        i = j;
+      }
+    }
+    table[i] = 0;
+    num_entries--;
+    if (num_entries < next_shrink) {
+      resizeOpen(size / 2);
+    }
+    return item;
+  }
+
   unsigned h = hash%size;
 
   MEDDLY_CHECK_RANGE(0, h, size);
@@ -238,6 +295,8 @@ void MEDDLY::unique_table::subtable::clear()
 {
   if (parent != 0) {
     free(table);
+    free(hashes);
+    hashes = nullptr;
     init(parent);
   }
 }
@@ -252,7 +311,8 @@ unsigned MEDDLY::unique_table::subtable::getItems(node_handle* items, unsigned s
       if(k == sz){
         return k;
       }
-      curr = parent->getNext(curr);
+      // open addressing: one item per slot
+      curr = hashes ? 0 : parent->getNext(curr);
     }
   }
 
@@ -348,3 +408,37 @@ void MEDDLY::unique_table::subtable::shrink()
   else                 next_shrink = size / 2;
   buildFromList(ptr);
 }
+
+void MEDDLY::unique_table::subtable::resizeOpen(unsigned newSize)
+{
+#ifdef DEBUG_SLOW
+  fprintf(stderr, "Resizing unique table (current size: %d, new size: %d)\n", size, newSize);
+#endif
+  node_handle* old_table = table;
+  unsigned* old_hashes = hashes;
+  unsigned old_size = size;
+
+  table = static_cast<node_handle*>(calloc(newSize, sizeof(node_handle)));
+  hashes = static_cast<unsigned*>(malloc(newSize * sizeof(unsigned)));
+  if (table == nullptr || hashes == nullptr) {
+    fprintf(stderr, "Error in allocating array of size %lu at %s, line %d\n",
+        size_t(newSize * (sizeof(node_handle) + sizeof(unsigned))), __FILE__, __LINE__);
+    throw error(error::INSUFFICIENT_MEMORY, __FILE__, __LINE__);
+  }
+  size = newSize;
+  next_expand = (size >= MAX_SIZE ? std::numeric_limits<unsigned int>::max() : size / 2);
+  next_shrink = (size <= MIN_SIZE ? 0 : size / 8);
+
+  // the stored hashes spare recomputing them from the nodes
+  for (unsigned i = 0; i < old_size; i++) {
+    if (old_table[i] == 0) continue;
+    unsigned h = old_hashes[i] & (size-1);
+    while (table[h] != 0) {
+      h = (h+1) & (size-1);
+    }
+    table[h] = old_table[i];
+    hashes[h] = old_hashes[i];
+  }
+  free(old_table);
+  free(old_hashes);
+}
@@ -41,7 +41,9 @@ private:
 
     inline unsigned getSize() const         { return size; }
     inline unsigned getNumEntries() const   { return num_entries; }
-    inline unsigned getMemUsed() const      { return size * sizeof(node_handle); }
+    inline unsigned getMemUsed() const      {
+      return size * (sizeof(node_handle) + (hashes ? sizeof(unsigned) : 0));
+    }
 
     void reportStats(output &s, const char* pad, unsigned flags) const;
 
@@ -50,10 +52,12 @@ private:
 
     /**
      * Initialize the sub table. Must be called before use.
+     * The implementation is chosen by the forest policies.
      */
     void init(expert_forest *ef);
 
-    /** If table contains key, move it to the front of the list.
+    /** If table contains key, move it to the front of the list
+            (chained tables only).
             Otherwise, do nothing.
             Returns the item if found, 0 otherwise.
 
@@ -102,6 +106,9 @@ private:
     /// Shrink the hash table
     void shrink();
 
+    /// Open addressing: move the items into a table of the given size.
+    void resizeOpen(unsigned newSize);
+
   private:
     expert_forest* parent;
     unsigned size;
@@ -109,6 +116,8 @@ private:
     unsigned next_expand;
     unsigned next_shrink;
     node_handle* table;
+    /// Open addressing: hash of the item in each slot; null for chained tables.
+    unsigned* hashes;
 
     static const unsigned MAX_SIZE = 1073741824;
     static const unsigned MIN_SIZE = 8;
@@ -190,6 +199,16 @@ inline unsigned MEDDLY::unique_table::getMemUsed(int var) const
 template <typename T>
 MEDDLY::node_handle MEDDLY::unique_table::subtable::find(const T &key) const
 {
+  if (hashes) {
+    const unsigned hash = key.hash();
+    for (unsigned h = hash & (size-1); table[h] != 0; h = (h+1) & (size-1)) {
+      if (hashes[h] == hash && parent->areDuplicates(table[h], key)) {
+        return table[h];
+      }
+    }
+    return 0;
+  }
+
   unsigned h = key.hash() % size;
   MEDDLY_CHECK_RANGE(0, h, size);
   node_handle prev = 0;
@@ -25,6 +25,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include <queue> 
 #include <chrono>
+#include <sys/stat.h>
 
 #include "mtmdd.hpp"
 
@@ -76,12 +77,16 @@ void MultiterminalDecisionDiagram::load_from_graph_db(const GraphsDB& graphs_db)
     Buffer dd_buffer(buffersize, num_vars + 1, true); 
     MtmddLoaderListener mlistener(*this, dd_buffer); 
 
+    if (bulk_run_size > 0) 
+        bulk_loader.reset(new BulkLoader(forest, bulk_run_size)); 
+
     while (!graphs_queue.empty()) {
         GRAPESLib::Graph& current_graph = graphs_queue.front(); 
         std::map<int, std::vector<GRAPESLib::GNode*>> nodes_per_label; 
 
         //group nodes of the current graph by their labels
         for (int i = 0; i < current_graph.nodes_count; ++i) {
+            indexStats.add_vertex(current_graph.id, current_graph.nodes[i].label + 1); 
             nodes_per_label.emplace(
                 std::piecewise_construct, 
                 std::forward_as_tuple(current_graph.nodes[i].label), 
@@ -103,6 +108,9 @@ void MultiterminalDecisionDiagram::load_from_graph_db(const GraphsDB& graphs_db)
             partial_index.visit(mlistener); 
         }
 
+        //nodes are encoded while visiting the tries 
+        vertexSignatures.add_graph(current_graph, graphNodeMapping); 
+
         graphs_queue.pop(); 
     }
 
@@ -111,34 +119,56 @@ void MultiterminalDecisionDiagram::load_from_graph_db(const GraphsDB& graphs_db)
         insert(dd_buffer); 
     }
 
+    if (bulk_loader) {
+        MEDDLY::dd_edge loaded(forest); 
+        bulk_loader->build(loaded); 
+        bulk_loader.reset(); 
+        MEDDLY::apply(MEDDLY::PLUS, *root, loaded, *root); 
+    }
+
+    //the nodes kept by a deferred collection are freed once the index is complete 
+    if (!forest->isPessimistic()) 
+        deferred_gc.collect(static_cast<MEDDLY::expert_forest*>(forest)); 
+
     labelMapping.initFromGrapesLabelMap(labelMap); 
     graphNodeMapping.build_inverse_mapping();    
+    indexStats.build_label_table(); 
 }
 
 
 
 void MultiterminalDecisionDiagram::write(const std::string& out_ddfile) {
+    if (compact_index) 
+        throw std::logic_error("A compacted index cannot be written"); 
+
     std::string outfilename = grapes2dd::get_dd_index_name(out_ddfile, size() - 1);
     std::ofstream fo(outfilename); 
+    write_metadata(fo); 
+    fo.close(); 
+
+    FILE *fp = fopen(outfilename.c_str(), "a"); 
+    MEDDLY::FILE_output handler(fp); 
+    forest->writeEdges(handler, this->root, 1);
+    fclose(fp); 
+
+    //statistics are stored after the diagram, so that older indexes are still readable 
+    fo.open(outfilename, std::ios::out | std::ios::app); 
+    fo << "\n" << indexStats << vertexSignatures; 
+    fo.close(); 
+}
 
+
+void MultiterminalDecisionDiagram::write_metadata(std::ostream& fo) {
     fo  << size() << " "                    //mtmdd depth 
         << labelMapping.size() << " "       //number of labels
         << graphNodeMapping.size() << "\n"  //number of vertices 
         << *v_order                         //variable ordering
         << labelMapping                     //labels sorted by mapped value 
         << graphNodeMapping;                //graphs nodes sorted by mapped values 
-    fo.close(); 
-
-    FILE *fp = fopen(outfilename.c_str(), "a"); 
-    MEDDLY::FILE_output handler(fp); 
-    forest->writeEdges(handler, this->root, 1);
-    fclose(fp); 
 }
 
 
-void MultiterminalDecisionDiagram::read(const std::string& in_ddfile, const size_t lp) {
-    std::string infilename = grapes2dd::get_dd_index_name(in_ddfile, lp); 
-    std::ifstream fi(infilename, std::ios::in);
+size_t MultiterminalDecisionDiagram::read_metadata(std::ifstream& fi) {
     int depth, nlabels, nvertices; 
 
     fi >> depth >> nlabels >> nvertices; 
@@ -149,23 +179,97 @@ void MultiterminalDecisionDiagram::read(const std::string& in_ddfile, const size
     labelMapping.read(fi, nlabels);   
     graphNodeMapping.read(fi);  
     size_t num_graphs_in_db = graphNodeMapping.num_graphs();
-    
+
+    //one line for each mtmdd level, label and graph, plus the header and the total number of graphs 
+    return depth + nlabels + num_graphs_in_db + 2; 
+}
+
+
+void MultiterminalDecisionDiagram::read(const std::string& in_ddfile, const size_t lp) {
+    std::string infilename = grapes2dd::get_dd_index_name(in_ddfile, lp); 
+    std::ifstream fi(infilename, std::ios::in);
+    const size_t metadata_lines = read_metadata(fi); 
     fi.close();
 
     FILE *fp = fopen(infilename.c_str(), "r");
-    /** skip those lines containing metadata we've already read; 
-     *  specifically: one line for each:
-     *  - mtmdd level, 
-     *  - label,
-     *  - graph, 
-     *  PLUS two additional lines (the header and the total number of graphs) */
-    for (int lines_to_skip = depth + nlabels + num_graphs_in_db + 2; lines_to_skip > 0; --lines_to_skip) 
+    //skip those lines containing metadata we've already read 
+    for (size_t lines_to_skip = metadata_lines; lines_to_skip > 0; --lines_to_skip) 
         if (fscanf(fp, "%*[^\n]\n") != 0)
             throw std::logic_error("This cannot happen! If it happens, there is something really wrong!");
 
     MEDDLY::FILE_input handler(fp);
     forest->readEdges(handler, this->root, 1);
+    long stats_offset = ftell(fp); 
     fclose(fp);  
+
+    //read the statistics section following the diagram, if present 
+    fi.open(infilename, std::ios::in); 
+    fi.seekg(stats_offset); 
+    if (!indexStats.read(fi)) 
+        indexStats = IndexStatistics(); 
+    else 
+        vertexSignatures.read(fi); 
+    fi.close(); 
+}
+
+void MultiterminalDecisionDiagram::write_paged(const std::string& out_ddfile) {
+    std::unique_ptr<CompactDiagram> copy; 
+    const CompactDiagram* diagram = compact_index.get(); 
+    if (!diagram) {
+        copy.reset(new CompactDiagram(*root)); 
+        diagram = copy.get(); 
+    }
+
+    //the position of the diagram, following the metadata and the statistics, comes first 
+    std::ofstream fo(grapes2dd::get_dd_paged_index_name(out_ddfile, size() - 1), std::ios::out | std::ios::binary); 
+    uint64_t diagram_offset = 0; 
+    fo.write(reinterpret_cast<const char*>(&diagram_offset), sizeof(diagram_offset)); 
+    write_metadata(fo); 
+    fo << "\n" << indexStats << vertexSignatures; 
+    diagram_offset = diagram->write(fo); 
+    fo.seekp(0); 
+    fo.write(reinterpret_cast<const char*>(&diagram_offset), sizeof(diagram_offset)); 
+    fo.close(); 
+}
+
+
+bool MultiterminalDecisionDiagram::read_paged(const std::string& in_ddfile, const size_t lp, size_t memory_cap) {
+    const std::string infilename = grapes2dd::get_dd_index_name(in_ddfile, lp), 
+                      pagedfilename = grapes2dd::get_dd_paged_index_name(in_ddfile, lp); 
+    struct stat index_info, paged_info; 
+
+    if (stat(pagedfilename.c_str(), &paged_info) != 0) 
+        return false; 
+    if (stat(infilename.c_str(), &index_info) == 0 && 
+            std::make_pair(index_info.st_mtim.tv_sec, index_info.st_mtim.tv_nsec) > 
+            std::make_pair(paged_info.st_mtim.tv_sec, paged_info.st_mtim.tv_nsec)) 
+        return false; 
+
+    std::ifstream fi(pagedfilename, std::ios::in | std::ios::binary); 
+    uint64_t diagram_offset; 
+    fi.read(reinterpret_cast<char*>(&diagram_offset), sizeof(diagram_offset)); 
+    //a copy written in an older format is written again 
+    if (!fi || !CompactDiagram::written_at(fi, diagram_offset)) 
+        return false; 
+    fi.seekg(sizeof(diagram_offset)); 
+    read_metadata(fi); 
+    if (!indexStats.read(fi)) 
+        indexStats = IndexStatistics(); 
+    else 
+        vertexSignatures.read(fi); 
+    fi.close(); 
+
+    compact_index.reset(new CompactDiagram(pagedfilename, diagram_offset, memory_cap)); 
+    return true; 
+}
+
+
+void MultiterminalDecisionDiagram::compact() {
+    if (compact_index) 
+        return; 
+    compact_index.reset(new CompactDiagram(*root)); 
+    //the nodes of the index are released 
+    root->set(0); 
 }
 
 void MultiterminalDecisionDiagram::get_stats(StatsDD& stats) const {
@@ -173,13 +277,25 @@ void MultiterminalDecisionDiagram::get_stats(StatsDD& stats) const {
     stats.peak_nodes = forest->getPeakNumNodes(); 
     stats.memory_used = forest->getCurrentMemoryUsed();
     stats.peak_memory = forest->getPeakMemoryUsed(); 
-    stats.num_unique_nodes = root->getNodeCount();
-    stats.num_edges = root->getEdgeCount(); 
     stats.num_graphs = num_indexed_graphs();
     stats.num_labels = labelMapping.size();
     stats.num_vars = v_order->domain->getNumVariables(); 
     //domain->getNumVariables();
-    MEDDLY::apply(MEDDLY::CARDINALITY, *root, stats.cardinality);          
+    if (compact_index) {
+        stats.num_unique_nodes = compact_index->num_nodes(); 
+        stats.num_edges = compact_index->get_num_edges(); 
+        stats.memory_used += compact_index->memory_used(); 
+        stats.cardinality = compact_index->cardinality(); 
+        stats.page_reads = compact_index->page_reads(); 
+        stats.page_drops = compact_index->page_drops(); 
+    } else {
+        stats.num_unique_nodes = root->getNodeCount();
+        stats.num_edges = root->getEdgeCount(); 
+        MEDDLY::apply(MEDDLY::CARDINALITY, *root, stats.cardinality);          
+    }
+    stats.gc_runs = deferred_gc.collections; 
+    stats.gc_freed_nodes = deferred_gc.freed_nodes; 
+    stats.ct.read(); 
 }
 
 
@@ -188,8 +304,10 @@ void MtmddLoaderListener::visit_node(GRAPESLib::OCPTreeNode& n) {
     std::vector<node_label_t> path; 
     std::vector<int>* slot = nullptr; 
     size_t pathlength = grapes2dd::get_path_from_node(n, path, max_pathlength); 
+    long path_vertices = 0, path_occurrences = 0; 
 
     for (auto oit = n.gsinfos.begin(); oit != n.gsinfos.end(); ++oit) {
+        path_occurrences += oit->second.path_occurrence; 
         //iterate over starting nodes of the current path in the current graph 
         for (sbitset::iterator sit = oit->second.from_nodes.first_ones(); sit != oit->second.from_nodes.end(); sit.next_ones()) { 
             //get the first slot in the buffer 
@@ -203,6 +321,7 @@ void MtmddLoaderListener::visit_node(GRAPESLib::OCPTreeNode& n) {
             );  
             //store number of occurrences of the path in the current graph 
             _buffer.save_value(oit->second.path_occurrence); 
+            ++path_vertices; 
 
             if (!more_slots_available) {  
                 _mtmdd.insert(_buffer); 
@@ -210,6 +329,9 @@ void MtmddLoaderListener::visit_node(GRAPESLib::OCPTreeNode& n) {
             }
         }
     }
+
+    if (path_vertices > 0) 
+        _mtmdd.indexStats.add_path(path, path_vertices, n.gsinfos.size(), path_occurrences); 
 }
 
 void QueryListener::visit_node(GRAPESLib::OCPTreeNode& n) {
@@ -247,17 +369,11 @@ void QueryListener::visit_node(GRAPESLib::OCPTreeNode& n) {
 }
 
 
-std::vector<GraphMatch> MultiterminalDecisionDiagram::match(const std::string& query_graph_file, unsigned nthreads, std::vector<double>& times) {
+std::unique_ptr<IndexedQuery> MultiterminalDecisionDiagram::index_query(const std::string& query_graph_file, unsigned nthreads) {
+    std::unique_ptr<IndexedQuery> query(new IndexedQuery(*v_order, size() + 1)); 
     std::ifstream is(query_graph_file.c_str(), std::ios::in);
     GRAPESLib::OCPTree query_tree;
     const int max_depth = size() - 1;
-    const VariableOrdering& var_ordering = *v_order; 
-
-    time_point start_query_indexing, start_dd_intersection, start_query_filtering; 
-    time_point end_query_indexing, end_dd_intersection, end_query_filtering; 
-
-    // start query indexing 
-    start_query_indexing = std::chrono::_V2::steady_clock::now(); 
 
     GRAPESLib::LabelMap grapesLabelMap; 
     labelMapping.initGrapesLabelMap(grapesLabelMap); 
@@ -272,21 +388,105 @@ std::vector<GraphMatch> MultiterminalDecisionDiagram::match(const std::string& q
     buildrun.run();
     is.close();
 
+    //read the query graph again, since the trie does not keep it 
+    std::ifstream qis(query_graph_file.c_str(), std::ios::in);
+    GRAPESLib::GraphReader_gff qreader(grapesLabelMap, qis);
+    qreader.direct = direct_indexing; 
+    qreader.readGraph(query->graph); 
+    qis.close(); 
+
     //2. create dd without no node info from trie 
-    QueryListener ql(var_ordering, max_depth + 2, true); 
-    query_tree.visit(ql); 
+    query_tree.visit(query->listener); 
+    return query; 
+}
+
+
+void MultiterminalDecisionDiagram::get_query_form(const IndexedQuery& query, QueryForm& form) const {
+    const QueryPattern& qpattern = query.listener.query; 
+    std::ostringstream paths_key; 
+
+    //paths are sorted by labels in the query pattern 
+    for (const LabelledPath& path: qpattern.unique_paths) {
+        for (const node_label_t& label: path) 
+            paths_key << label << " "; 
+        paths_key << ": " << path.get_occurrence_number() 
+                  << " " << qpattern.find_starting_nodes(path).size() << ", "; 
+    }
+
+    form = QueryForm(query.graph, paths_key.str()); 
+}
+
+
+std::vector<GraphMatch> MultiterminalDecisionDiagram::match(IndexedQuery& query, unsigned nthreads, std::vector<double>& times, 
+        GRAPESLib::Deadline* deadline, std::map<std::string, double>* progress) {
+    const VariableOrdering& var_ordering = *v_order; 
+
+    time_point start_query_indexing, start_dd_intersection, start_query_filtering; 
+    time_point end_query_indexing, end_dd_intersection, end_query_filtering; 
+
+    // start query indexing 
+    start_query_indexing = std::chrono::_V2::steady_clock::now(); 
+
+    //signatures of the query nodes, checked against the indexed vertices 
+    std::vector<VertexSignature> query_signatures; 
+    if (!vertexSignatures.empty()) 
+        VertexSignature::compute(query.graph, query_signatures); 
+
+    //choose the query paths used to intersect the index 
+    QueryPattern& qpattern = query.listener.query; 
+    qpattern.node_signatures.swap(query_signatures); 
+    if (query_path_selection) 
+        qpattern.select_filtering_paths(indexStats); 
+    else 
+        qpattern.select_all_paths(); 
 
     end_query_indexing = std::chrono::_V2::steady_clock::now();
     times.push_back(get_time_interval(end_query_indexing, start_query_indexing)); 
     //end query indexing
 
-    Buffer& b = ql.buffer; 
     //3. extract query paths from index
     start_dd_intersection = std::chrono::_V2::steady_clock::now(); 
 
+    std::vector<int*> filtering_slots; 
+    std::vector<long> filtering_occurrences; 
+    for (const LabelledPath* path: qpattern.filtering_paths) {
+        filtering_slots.push_back(path->get_pointer2buffer()); 
+        filtering_occurrences.push_back(path->get_occurrence_number()); 
+    }
+
     MEDDLY::dd_edge query_dd(forest), query_matched(forest); 
-    forest->createEdge(b.data(), b.values_data(), b.num_elements(), query_dd); 
-    MEDDLY::apply(MEDDLY::MULTIPLY, *root, query_dd, query_matched); 
+    forest->createEdge(filtering_slots.data(), filtering_occurrences.data(), filtering_slots.size(), query_dd); 
+
+    //the intersection cannot be interrupted, it is skipped if the budget has already passed 
+    const bool timed_out = deadline && deadline->passed(); 
+
+    /* a graph cannot contain the query if it has fewer vertices of some label than the query: 
+     * the vertices of the remaining graphs are masked, so that discarded graphs are never enumerated */ 
+    if (!timed_out && !indexStats.empty()) {
+        std::map<node_label_t, long> query_labels; 
+        std::vector<graph_id_t> candidate_graphs; 
+        qpattern.get_label_counts(query_labels); 
+        indexStats.filter_graphs(query_labels, candidate_graphs); 
+
+        if (candidate_graphs.size() < num_indexed_graphs()) {
+            const int vertex_var = var_ordering.size(); 
+            std::vector<long> vertex_mask(forest->getDomain()->getVariableBound(vertex_var), 0); 
+            MEDDLY::dd_edge mask_dd(forest); 
+
+            for (const graph_id_t& graph_id: candidate_graphs) 
+                graphNodeMapping.mark_nodes(graph_id, vertex_mask); 
+
+            forest->createEdgeForVar(vertex_var, false, vertex_mask.data(), mask_dd); 
+            MEDDLY::apply(MEDDLY::MULTIPLY, query_dd, mask_dd, query_dd); 
+        }
+    }
+
+    if (!timed_out && compact_index) {
+        compact_index->multiply(query_dd, query_matched); 
+    } else if (!timed_out) {
+        MEDDLY::apply(MEDDLY::MULTIPLY, *root, query_dd, query_matched); 
+        ct_sizer.check(); 
+    }
 
     end_dd_intersection = std::chrono::_V2::steady_clock::now();
     times.push_back(get_time_interval(end_dd_intersection, start_dd_intersection)); 
@@ -296,10 +496,13 @@ std::vector<GraphMatch> MultiterminalDecisionDiagram::match(const std::string& q
     std::vector<GraphMatch> matched_graphs; 
     start_query_filtering = std::chrono::_V2::steady_clock::now(); 
 
-    QueryPattern& qpattern = ql.query; 
     qpattern.assign_dd_edge(&query_dd); 
-    MatchedQuery mq(qpattern, graphNodeMapping, var_ordering); 
-    mq.match(query_matched, matched_graphs); 
+    MatchedQuery mq(qpattern, graphNodeMapping, var_ordering, vertexSignatures); 
+    mq.compact_index = compact_index.get(); 
+    if (!timed_out)
+        mq.match(*root, query_matched, matched_graphs, nthreads, deadline); 
+    if (progress)
+        (*progress)["n_filtered_vertices"] = mq.filtered_vertices; 
 
     end_query_filtering = std::chrono::_V2::steady_clock::now();
     times.push_back(get_time_interval(end_query_filtering, start_query_filtering)); 
@@ -312,6 +515,20 @@ std::vector<GraphMatch> MultiterminalDecisionDiagram::match(const std::string& q
 }
 
 
+//it writes a line for each minterm visited by @e, with the values of the first @offset - 1 levels 
+template <typename Enumerator>
+static void write_minterms(Enumerator& e, const int offset, std::ostream& fout) {
+    for (; e; ++e) {
+        const int *variables = e.getAssignments(); 
+        int value; 
+        e.getValue(value); 
+
+        std::ostringstream stream; 
+        std::copy(variables + 1, variables + offset, std::ostream_iterator<int>(stream, "\t"));
+        fout << stream.str() << value << "\n";
+    } 
+}
+
 void MultiterminalDecisionDiagram::save_data(const std::string& filename) {
     std::ofstream fout(filename, std::ios::out); 
     const var_order_t& order = v_order->var_order; 
@@ -326,15 +543,13 @@ void MultiterminalDecisionDiagram::save_data(const std::string& filename) {
         fout << *it << "\t";
     fout << "\n"; 
     
-    for (MEDDLY::enumerator e(*root); e; ++e) {
-        const int *variables = e.getAssignments(); 
-        int value; 
-        e.getValue(value); 
-
-        std::ostringstream stream; 
-        std::copy(variables + 1, variables + offset, std::ostream_iterator<int>(stream, "\t"));
-        fout << stream.str() << value << "\n";
-    } 
+    if (compact_index) {
+        CompactDiagram::enumerator e(*compact_index); 
+        write_minterms(e, offset, fout); 
+    } else {
+        MEDDLY::enumerator e(*root); 
+        write_minterms(e, offset, fout); 
+    }
 }
 
 
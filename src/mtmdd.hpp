@@ -26,13 +26,17 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef MTDDS_HPP
 #define MTDDS_HPP 
 
+#include <memory>
 #include <unordered_map>
 #include <meddly.h>
 #include <meddly_expert.h>
 
 #include "matching.hpp"
 #include "buffer.hpp"
+#include "bulk_loader.hpp"
+#include "compact_dd.hpp"
 #include "dd_utils.hpp"
+#include "query_cache.hpp"
 
 #include "OCPTreeListeners.h"
 #include "GRAPESIndex.h"
@@ -57,6 +61,7 @@ namespace mtmdd {
     class MultiterminalDecisionDiagram; 
     class MtmddLoaderListener; //to load data from partial tries to the mtmdd
     class QueryListener; 
+    struct IndexedQuery; 
 
 
 
@@ -76,16 +81,33 @@ namespace mtmdd {
     public:
         Encoder labelMapping; 
         GraphNodeEncoder graphNodeMapping; 
+        IndexStatistics indexStats; 
+        VertexSignatures vertexSignatures; 
 
         bool direct_indexing = true; 
+        //intersect the index only with the query paths that are not implied by longer ones 
+        bool query_path_selection = true; 
+        /* paths per sorted run of the bulk loader: if positive, the index is built bottom-up from runs 
+         * spilled to disk, instead of summing batches of paths into it */ 
+        size_t bulk_run_size = 0; 
    //     size_t num_graphs_in_db = 0; 
     public: 
         VariableOrdering *v_order = nullptr;
 
         MEDDLY::forest::policies policy; 
+        //limit to the compute table, raised while it pays off 
+        ComputeTableSizer ct_sizer; 
+        //garbage collection of the nodes left behind by the insertions, if deferred 
+        DeferredCollector deferred_gc; 
 
         MEDDLY::forest *forest = nullptr; 
         MEDDLY::dd_edge *root = nullptr; 
+    private: 
+        //it collects the paths while the index is bulk loaded 
+        std::unique_ptr<BulkLoader> bulk_loader; 
+        //read-only copy of the index, replacing root once compacted 
+        std::unique_ptr<CompactDiagram> compact_index; 
+    public: 
         
         inline size_t num_indexed_graphs() const {
             // return num_graphs_in_db; 
@@ -94,6 +116,12 @@ namespace mtmdd {
     private:
         void load_from_graph_db(const GraphsDB& graphs_db);
 
+        //labels, vertices and variable ordering, written before the diagram 
+        void write_metadata(std::ostream& fo); 
+
+        //it initializes the forest from the metadata, returning the number of lines read 
+        size_t read_metadata(std::ifstream& fi); 
+
     public: 
         //empty decision diagram with uninitialized domain (has to be defined before initialization)
         MultiterminalDecisionDiagram() : policy(false) {
@@ -158,6 +186,58 @@ namespace mtmdd {
             load_from_graph_db(graphs_db); 
         }
 
+        //number of threads computing the sums and products of the forest, 1 to compute them sequentially 
+        inline void set_apply_threads(int nthreads) {
+            policy.apply_threads = nthreads; 
+            if (forest) 
+                forest->getPolicies().apply_threads = nthreads; 
+        }
+
+        //look up the nodes in open addressing unique tables instead of chained ones; it applies to the forests created afterwards 
+        inline void set_open_unique_table(bool open) {
+            if (open) 
+                policy.setOpenUniqueTable(); 
+            else 
+                policy.setChainedUniqueTable(); 
+        }
+
+        /* memory budget in bytes of the compute table: once full, the table grows while its hit rate improves, 
+         * within the budget; 0 keeps its size limit fixed */
+        inline void set_ct_budget(size_t budget) {
+            ct_sizer.memory_budget = budget; 
+        }
+
+        /* nodes left without incoming edges while building are kept, with their cached results, until the forest 
+         * takes @threshold bytes, and then collected at once; 0 frees them at once. It applies to the forests created afterwards */
+        inline void set_deferred_gc(size_t threshold) {
+            deferred_gc.memory_threshold = threshold; 
+            if (threshold > 0) {
+                policy.setOptimistic(); 
+                //only the deferred collection runs 
+                policy.orphanTrigger = std::numeric_limits<int>::max(); 
+                policy.compactBeforeExpand = false; 
+            } else {
+                policy.setPessimistic(); 
+            }
+        }
+
+        /* nodes stored in an mmap arena of @budget bytes, backed by transparent huge pages if @huge_pages:
+         * past it, creating a node throws MEDDLY::error INSUFFICIENT_MEMORY; 0 grows the node storage with realloc.
+         * It applies to the forests created afterwards */
+        inline void set_node_budget(size_t budget, bool huge_pages) {
+            if (budget > 0) {
+                policy.nodemm = MEDDLY::ARENA_MANAGER;
+                MEDDLY::setArenaBudget(budget, huge_pages);
+            } else {
+                policy.nodemm = MEDDLY::ARRAY_PLUS_GRID;
+            }
+        }
+
+        //it brings the compute table back to its initial size limit, between two queries
+        inline void relax_compute_table() {
+            ct_sizer.relax(); 
+        }
+
         /** Variable ordering methods **/ 
         inline void get_variable_ordering(var_order_t& var_order) {
             v_order->get(var_order); 
@@ -174,11 +254,17 @@ namespace mtmdd {
 
         //it stores the values contained in the Buffer structure into the current mtmdd 
         inline void insert(Buffer& buffer) {
+            if (bulk_loader) {
+                bulk_loader->add(buffer); 
+                return; 
+            }
             try {
                 MEDDLY::dd_edge tmp(forest); 
                 forest->createEdge(buffer.data(), buffer.values_data(), buffer.num_elements(), tmp); 
                 MEDDLY::apply(MEDDLY::PLUS, *root, tmp, *root); 
                 tmp.clear(); 
+                ct_sizer.check(); 
+                deferred_gc.check(static_cast<MEDDLY::expert_forest*>(forest)); 
             } catch (MEDDLY::error& e) {
                 std::cerr 
                     << "Data insertion into mtmdd failed with the following meddly error: " 
@@ -188,8 +274,18 @@ namespace mtmdd {
             }
         }
 
-        //search all the occurrences of the query subgraph in the indexed graphs 
-        std::vector<GraphMatch> match(const std::string& query_graph_file, unsigned nthreads, std::vector<double>& times); 
+    public: 
+        /* it reads a query graph and extracts its paths, once for both the cache lookup and the matching */ 
+        std::unique_ptr<IndexedQuery> index_query(const std::string& query_graph_file, unsigned nthreads); 
+
+        //it computes the canonical form of an indexed query, used to look up cached results 
+        void get_query_form(const IndexedQuery& query, QueryForm& form) const; 
+
+        /* search all the occurrences of the indexed query in the indexed graphs; 
+         * once @deadline passes, the phases left are skipped and the candidates found so far are returned. 
+         * The number of index vertices enumerated goes to @progress, as "n_filtered_vertices" */ 
+        std::vector<GraphMatch> match(IndexedQuery& query, unsigned nthreads, std::vector<double>& times, 
+            GRAPESLib::Deadline* deadline = nullptr, std::map<std::string, double>* progress = nullptr); 
 
         //it creates a pdf file representing the current mtdd - nb. it requires graphviz library! 
         void writePicture(const std::string& pdffile) const {
@@ -208,6 +304,23 @@ namespace mtmdd {
         //it fill this mtmdd loading data from a file 
         void read(const std::string& in_ddfile, const size_t lp); 
 
+        /* it moves the index out of the forest, into a read-only copy laid out for the queries: 
+         * its nodes are released, and the index cannot be changed nor written afterwards */ 
+        void compact(); 
+
+        inline bool is_compact() const {
+            return compact_index != nullptr; 
+        }
+
+        /* it writes the compact index, with the metadata of the index, to a paged index file next to the index file; 
+         * the index is compacted first, if it is not */ 
+        void write_paged(const std::string& out_ddfile); 
+
+        /* it opens the paged index file, if it is not older than the index file, instead of reading the index: 
+         * the nodes are read from disk when the queries visit them, keeping about @memory_cap bytes of them in memory. 
+         * It returns false if there is no up to date paged index */ 
+        bool read_paged(const std::string& in_ddfile, const size_t lp, size_t memory_cap); 
+
         //it returns a set of stats of the current mtmdd 
         void get_stats(StatsDD& stats) const;
 
@@ -234,6 +347,15 @@ namespace mtmdd {
         }
     }; 
 
+    //paths of a query, with the query graph they were extracted from 
+    struct IndexedQuery {
+        QueryListener listener; 
+        GRAPESLib::Graph graph; 
+
+        IndexedQuery(const VariableOrdering& var_ordering, size_t elem_size) 
+        : listener(var_ordering, elem_size, true), graph(0) {}
+    }; 
+
 
     class MtmddLoaderListener : public GRAPESLib::OCPTreeVisitListener {
     public: 
@@ -258,6 +380,11 @@ namespace grapes2dd {
         return input_network_file + "." + std::to_string(lp) + ".index.mtdd";
     }
 
+    //file of the compact index, queried from disk 
+    inline std::string get_dd_paged_index_name(const std::string& input_network_file, const size_t lp) {
+        return get_dd_index_name(input_network_file, lp) + ".paged";
+    }
+
     inline bool dd_already_indexed(const std::string& input_network_file, const size_t lp) {
         return std::ifstream(get_dd_index_name(input_network_file, lp)).good(); 
     }
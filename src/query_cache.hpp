@@ -0,0 +1,269 @@
+/*
+Copyright (c) 2020
+
+GRAPES is provided under the terms of The MIT License (MIT):
+
+Permission is hereby granted, free of charge, to any person
+obtaining a copy of this software and associated documentation
+files (the "Software"), to deal in the Software without restriction,
+including without limitation the rights to use, copy, modify, merge,
+publish, distribute, sublicense, and/or sell copies of the Software,
+and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef QUERY_CACHE_HPP
+#define QUERY_CACHE_HPP
+
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+#include "dd_utils.hpp"
+#include "Graph.h"
+
+
+namespace mtmdd {
+    class QueryForm;
+    class QueryCache;
+
+    /** QueryForm is the canonical form of a query graph: isomorphic queries have the same key.
+     * The key is made of the multiset of the labelled paths of the query and of a colour refinement hash;
+     * since different graphs may share it, the adjacency is kept to check isomorphism on a cache hit. */
+    class QueryForm {
+        std::vector<node_label_t> labels;
+        std::vector<std::set<unsigned>> out_neighbours;
+        std::vector<std::set<unsigned>> in_neighbours;
+        //stable colour of each node after the refinement
+        std::vector<size_t> colours;
+        size_t num_edges = 0;
+
+        inline bool has_edge(unsigned from, unsigned to) const {
+            return out_neighbours.at(from).count(to) > 0;
+        }
+
+        //1-dimensional Weisfeiler-Lehman refinement, starting from node labels
+        void refine_colours() {
+            const size_t n = labels.size();
+            std::hash<std::string> hasher;
+            std::vector<size_t> next(n);
+            size_t num_colours = 0;
+
+            colours.assign(labels.begin(), labels.end());
+
+            for (size_t round = 0; round < n; ++round) {
+                for (size_t i = 0; i < n; ++i) {
+                    std::multiset<size_t> out_colours, in_colours;
+                    std::ostringstream signature;
+
+                    for (const unsigned& v: out_neighbours[i]) out_colours.insert(colours[v]);
+                    for (const unsigned& v: in_neighbours[i])  in_colours.insert(colours[v]);
+
+                    signature << colours[i] << "|";
+                    for (const size_t& c: out_colours) signature << c << " ";
+                    signature << "|";
+                    for (const size_t& c: in_colours) signature << c << " ";
+                    next[i] = hasher(signature.str());
+                }
+
+                const size_t num_next = std::set<size_t>(next.begin(), next.end()).size();
+                colours.swap(next);
+                //partition is stable when the number of colour classes does not grow
+                if (num_next == num_colours)
+                    break;
+                num_colours = num_next;
+            }
+        }
+
+        //backtracking on nodes with equal colour, mapping query nodes in order
+        bool extend_mapping(const QueryForm& other, std::vector<int>& mapping, std::vector<bool>& used, unsigned node) const {
+            if (node == labels.size())
+                return true;
+
+            for (unsigned cand = 0; cand < other.labels.size(); ++cand) {
+                if (used[cand] || other.colours[cand] != colours[node] || other.labels[cand] != labels[node])
+                    continue;
+
+                bool consistent = true;
+                for (unsigned prev = 0; consistent && prev < node; ++prev) {
+                    consistent = has_edge(node, prev) == other.has_edge(cand, mapping[prev])
+                              && has_edge(prev, node) == other.has_edge(mapping[prev], cand);
+                }
+                consistent = consistent && has_edge(node, node) == other.has_edge(cand, cand);
+
+                if (consistent) {
+                    mapping[node] = cand;
+                    used[cand] = true;
+                    if (extend_mapping(other, mapping, used, node + 1))
+                        return true;
+                    used[cand] = false;
+                }
+            }
+            return false;
+        }
+
+    public:
+        //sorted multiset of the labelled paths of the query, with their occurrences
+        std::string paths_key;
+
+        QueryForm() {}
+
+        QueryForm(const GRAPESLib::Graph& g, const std::string& paths_key)
+        : labels(g.nodes_count), out_neighbours(g.nodes_count), in_neighbours(g.nodes_count), paths_key(paths_key) {
+            for (node_id_t i = 0; i < g.nodes_count; ++i) {
+                labels[i] = g.nodes[i].label;
+                for (const node_id_t& v: g.nodes[i].out_neighbors) {
+                    out_neighbours[i].insert(v);
+                    in_neighbours[v].insert(i);
+                    ++num_edges;
+                }
+            }
+            refine_colours();
+        }
+
+        //key used to look up the cache
+        std::string key() const {
+            std::multiset<size_t> colour_classes(colours.begin(), colours.end());
+            std::ostringstream out;
+
+            out << labels.size() << " " << num_edges << " " << paths_key << "#";
+            for (const size_t& c: colour_classes)
+                out << c << " ";
+            return out.str();
+        }
+
+        bool isomorphic(const QueryForm& other) const {
+            if (labels.size() != other.labels.size() || num_edges != other.num_edges)
+                return false;
+
+            std::vector<int> mapping(labels.size(), -1);
+            std::vector<bool> used(other.labels.size(), false);
+            return extend_mapping(other, mapping, used, 0);
+        }
+
+        //approximate number of bytes required to store this object
+        size_t memory_size() const {
+            size_t bytes = sizeof(QueryForm) + paths_key.size() + labels.size() * (sizeof(node_label_t) + sizeof(size_t));
+            for (const auto& neighbours: out_neighbours)
+                bytes += 2 * neighbours.size() * (sizeof(unsigned) + 32);
+            return bytes;
+        }
+    };
+
+
+    /** QueryCache stores the results of the last queries, evicting the least recently used ones
+     * when the given memory budget is exceeded. Results are valid for a single index:
+     * the cache is emptied as soon as the index file changes. */
+    class QueryCache {
+    public:
+        struct Entry {
+            QueryForm form;
+            //ids of the graphs surviving the filtering phase
+            std::vector<unsigned> candidate_graphs;
+            //statistics of the verification phase, as computed by graph_find
+            std::map<std::string, double> match_stats;
+
+            size_t memory_size() const {
+                return form.memory_size() + candidate_graphs.size() * sizeof(unsigned) + match_stats.size() * 64;
+            }
+        };
+
+    private:
+        using lru_list_t = std::list<std::pair<std::string, Entry>>;
+
+        //most recently used entries first
+        lru_list_t entries;
+        std::unordered_map<std::string, lru_list_t::iterator> entries_by_key;
+
+        size_t memory_budget;
+        size_t memory_used = 0;
+        //size and modification time of the index file the cached results come from
+        std::pair<off_t, time_t> index_fingerprint {-1, 0};
+
+        inline void evict(lru_list_t::iterator it) {
+            memory_used -= it->second.memory_size();
+            entries_by_key.erase(it->first);
+            entries.erase(it);
+        }
+
+    public:
+        long hits = 0;
+        long misses = 0;
+
+        //@budget is the maximum number of bytes used by cached entries
+        QueryCache(size_t budget) : memory_budget(budget) {}
+
+        inline size_t size() const {
+            return entries.size();
+        }
+
+        inline void clear() {
+            entries.clear();
+            entries_by_key.clear();
+            memory_used = 0;
+        }
+
+        /* it empties the cache if the index file has changed since the last check;
+         * it returns true if the cache has been invalidated */
+        bool validate(const std::string& index_file) {
+            struct stat info;
+            std::pair<off_t, time_t> fingerprint {-1, 0};
+
+            if (stat(index_file.c_str(), &info) == 0)
+                fingerprint = std::make_pair(info.st_size, info.st_mtime);
+
+            if (fingerprint == index_fingerprint)
+                return false;
+
+            index_fingerprint = fingerprint;
+            clear();
+            return true;
+        }
+
+        //it returns the cached results of a query isomorphic to @form, if any
+        const Entry* lookup(const QueryForm& form) {
+            auto it = entries_by_key.find(form.key());
+
+            if (it == entries_by_key.end() || !it->second->second.form.isomorphic(form)) {
+                ++misses;
+                return nullptr;
+            }
+            //move the entry in front of the list
+            entries.splice(entries.begin(), entries, it->second);
+            ++hits;
+            return &(entries.front().second);
+        }
+
+        void insert(const QueryForm& form, const std::vector<unsigned>& candidate_graphs, const std::map<std::string, double>& match_stats) {
+            std::string key(form.key());
+            auto it = entries_by_key.find(key);
+
+            if (it != entries_by_key.end())
+                evict(it->second);
+
+            entries.emplace_front(key, Entry{form, candidate_graphs, match_stats});
+            entries_by_key.emplace(key, entries.begin());
+            memory_used += entries.front().second.memory_size();
+
+            while (memory_used > memory_budget && !entries.empty())
+                evict(std::prev(entries.end()));
+        }
+    };
+}
+
+#endif